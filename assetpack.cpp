@@ -0,0 +1,126 @@
+#include "assetpack.h"
+#include <cstring>
+#include <SDL2/SDL.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetPack::~AssetPack() {
+    close();
+}
+
+bool AssetPack::open(const char* path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return false;
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)info.st_size;
+#endif
+
+    // Validate the header and table of contents before trusting any offsets
+    const PackHeader* header = reinterpret_cast<const PackHeader*>(data);
+    if (size < sizeof(PackHeader) || memcmp(header->magic, pack_magic, sizeof(pack_magic)) != 0 ||
+        header->version != pack_version ||
+        size < sizeof(PackHeader) + (uint64_t)header->count * sizeof(PackEntry)) {
+        close();
+        return false;
+    }
+    entries = reinterpret_cast<const PackEntry*>(data + sizeof(PackHeader));
+    count = header->count;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (entries[i].offset > size || entries[i].size > size - entries[i].offset) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void AssetPack::close() {
+    if (!data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap(const_cast<unsigned char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+    entries = nullptr;
+    count = 0;
+}
+
+const PackEntry* AssetPack::find(const char* name) const {
+    for (uint32_t i = 0; i < count; ++i) {
+        if (strncmp(entries[i].name, name, sizeof(entries[i].name)) == 0) return &entries[i];
+    }
+    return nullptr;
+}
+
+const void* AssetPack::view(const char* name, size_t* size) const {
+    const PackEntry* entry = find(name);
+    if (!entry) return nullptr;
+    *size = (size_t)entry->size;
+    return data + entry->offset;
+}
+
+SDL_RWops* AssetPack::openAsset(const char* name) const {
+    const PackEntry* entry = find(name);
+    if (!entry) {
+        SDL_SetError("%s is not in the asset pack", name);
+        return nullptr;
+    }
+    return SDL_RWFromConstMem(data + entry->offset, (int)entry->size);
+}
+
+void AssetPack::evict(const void* begin, size_t bytes) const {
+    uintptr_t first = ((uintptr_t)begin + pack_alignment - 1) & ~(uintptr_t)(pack_alignment - 1);
+    uintptr_t last = ((uintptr_t)begin + bytes) & ~(uintptr_t)(pack_alignment - 1);
+    if (last <= first) return;
+#ifdef _WIN32
+    // Unlocking pages that were never locked takes them out of the working set
+    VirtualUnlock((void*)first, last - first);
+#else
+    // Unlike posix_madvise, which glibc ignores for this, madvise unmaps the pages of
+    // a private mapping straight away
+    madvise((void*)first, last - first, MADV_DONTNEED);
+#endif
+}
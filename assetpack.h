@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+struct SDL_RWops;
+
+// Asset pack file layout, written by packer.cpp and read back with AssetPack:
+//
+//   PackHeader | PackEntry[count] | padding | data... (each blob starts on a page boundary)
+//
+// All integers are little-endian. Blobs are page aligned so mapping the file and
+// touching one asset only faults in that asset's pages.
+const char pack_magic[8] = {'S', 'N', 'K', 'P', 'A', 'C', 'K', '1'};
+const uint32_t pack_version = 1;
+const uint64_t pack_alignment = 4096;
+
+struct PackHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+};
+
+struct PackEntry {
+    char name[48];
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Read-only view of a memory-mapped asset pack. Assets are handed to SDL as
+// SDL_RWFromConstMem streams over the mapping, so nothing is copied; the pack has
+// to stay open for as long as anything (fonts, music) still reads from them.
+class AssetPack {
+public:
+    AssetPack() = default;
+    ~AssetPack();
+
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+
+    const PackEntry* find(const char* name) const;
+    const void* view(const char* name, size_t* size) const;
+    SDL_RWops* openAsset(const char* name) const;
+
+    // Drops a range of the mapping from memory once it won't be read again soon; pages
+    // touched later are read back from the file. Only whole pages inside the range are
+    // affected.
+    void evict(const void* begin, size_t bytes) const;
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+    const PackEntry* entries = nullptr;
+    uint32_t count = 0;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#endif
+};
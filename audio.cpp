@@ -0,0 +1,172 @@
+#include "audio.h"
+#include <algorithm>
+#include "metrics.h"
+#include "spscqueue.h"
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+struct Voice {
+    const Sint16* samples = nullptr;
+    Uint32 length = 0;
+    Uint32 position = 0;
+    bool active = false;
+};
+
+struct SoundCommand {
+    SoundEvent event;
+    Uint64 triggered;
+};
+
+Voice voices[audio_voice_count];
+std::atomic<Mix_Chunk*> eventSounds[(int)SoundEvent::Count] = {};
+bool deviceOpen = false;
+bool automaticBuffer = false;
+int bufferSamples = 0;
+Uint64 lastCallback = 0;
+
+// Sound events from the simulation, drained by the audio callback
+SpscQueue<SoundCommand, 64> commands;
+
+// Saturating add of count interleaved samples into out
+void mixSamples(Sint16* out, const Sint16* in, Uint32 count) {
+    Uint32 i = 0;
+#if defined(__AVX2__)
+    for (; i + 16 <= count; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_adds_epi16(a, b));
+    }
+#endif
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_adds_epi16(a, b));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= count; i += 8) {
+        vst1q_s16(out + i, vqaddq_s16(vld1q_s16(out + i), vld1q_s16(in + i)));
+    }
+#endif
+    for (; i < count; ++i) {
+        int sample = out[i] + in[i];
+        out[i] = (Sint16)std::min(32767, std::max(-32768, sample));
+    }
+}
+
+void startVoice(const SoundCommand& command, Uint64 now, double bufferSeconds) {
+    Mix_Chunk* sound = eventSounds[(int)command.event].load(std::memory_order_acquire);
+    if (!sound) return;
+
+    Voice* voice = nullptr;
+    for (auto& candidate : voices) {
+        if (!candidate.active) {
+            voice = &candidate;
+            break;
+        }
+    }
+    if (!voice) {
+        voice = std::max_element(voices, voices + audio_voice_count,
+                                 [](const Voice& a, const Voice& b) { return a.position < b.position; });
+        metrics.voicesStolen++;
+    }
+
+    voice->samples = reinterpret_cast<const Sint16*>(sound->abuf);
+    voice->length = sound->alen / sizeof(Sint16);
+    voice->position = 0;
+    voice->active = true;
+
+    // The voice starts at the front of this buffer, which is heard once the buffer plays out
+    double waited = double(now - command.triggered) / SDL_GetPerformanceFrequency();
+    metrics.audioTriggerLatency.record((waited + bufferSeconds) * 1e6);
+}
+
+void mixVoices(void*, Uint8* stream, int len) {
+    const Uint64 now = SDL_GetPerformanceCounter();
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const double bufferSeconds = double(len) / (sizeof(Sint16) * audio_channels * audio_frequency);
+
+    metrics.audioCallbacks++;
+    if (lastCallback && double(now - lastCallback) / frequency > 1.5 * bufferSeconds) metrics.lateAudioCallbacks++;
+    lastCallback = now;
+
+    SoundCommand command;
+    while (commands.pop(command)) startVoice(command, now, bufferSeconds);
+
+    Sint16* out = reinterpret_cast<Sint16*>(stream);
+    Uint32 samples = len / sizeof(Sint16);
+    for (auto& voice : voices) {
+        if (!voice.active) continue;
+        Uint32 count = std::min(samples, voice.length - voice.position);
+        mixSamples(out, voice.samples + voice.position, count);
+        voice.position += count;
+        if (voice.position >= voice.length) voice.active = false;
+    }
+}
+
+bool openDevice(int samples) {
+    if (Mix_OpenAudioDevice(audio_frequency, AUDIO_S16SYS, audio_channels, samples, nullptr, 0) < 0) return false;
+    deviceOpen = true;
+    bufferSamples = samples;
+    lastCallback = 0;
+    metrics.audioBufferSamples = samples;
+    metrics.audioCallbacks = 0;
+    metrics.lateAudioCallbacks = 0;
+    Mix_SetPostMix(mixVoices, nullptr);
+    return true;
+}
+
+} // namespace
+
+bool openAudio(int samples) {
+    automaticBuffer = samples <= 0;
+    return openDevice(automaticBuffer ? audio_min_buffer : samples);
+}
+
+void closeAudio() {
+    if (!deviceOpen) return;
+    Mix_SetPostMix(nullptr, nullptr);
+    for (auto& voice : voices) voice.active = false;
+    Mix_CloseAudio();
+    deviceOpen = false;
+}
+
+bool audioEnabled() {
+    return deviceOpen;
+}
+
+void tuneAudioBuffer() {
+    if (!deviceOpen || !automaticBuffer) return;
+
+    int waited = 0;
+    while (bufferSamples < audio_max_buffer) {
+        uint64_t callbacks = metrics.audioCallbacks.load();
+        if (callbacks < 20) {
+            if (waited >= 1000) return;
+            SDL_Delay(50);
+            waited += 50;
+            continue;
+        }
+        if (metrics.lateAudioCallbacks.load() * 50 <= callbacks) return;
+
+        int next = bufferSamples * 2;
+        closeAudio();
+        if (!openDevice(next)) return;
+        waited = 0;
+    }
+}
+
+void setEventSound(SoundEvent event, Mix_Chunk* sound) {
+    eventSounds[(int)event].store(sound, std::memory_order_release);
+}
+
+void postSound(SoundEvent event) {
+    if (!deviceOpen) return;
+    commands.push({event, SDL_GetPerformanceCounter()});
+}
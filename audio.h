@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+
+const int audio_frequency = 44100;
+const int audio_channels = 2;
+const int audio_voice_count = 8;
+const int audio_min_buffer = 256;
+const int audio_max_buffer = 2048;
+
+enum class SoundEvent : Uint8 {
+    Eat,
+    Bonus,
+    Death,
+    Count
+};
+
+// Opens the mixer device in exactly this format (SDL converts if the hardware differs).
+// A buffer of 0 starts at audio_min_buffer samples and lets tuneAudioBuffer() grow it
+// if the device can't keep up.
+bool openAudio(int bufferSamples);
+void closeAudio();
+bool audioEnabled();
+
+// Doubles an automatically sized buffer while too many callbacks arrive late. Call once
+// the device has been running for a while (e.g. after loading) and before music starts.
+void tuneAudioBuffer();
+
+// Chooses the effect played for an event. Set these up before the simulation starts.
+void setEventSound(SoundEvent event, Mix_Chunk* sound);
+
+// Queues a sound for the game event. Safe to call from the simulation thread: it only
+// pushes onto a wait-free queue that the audio callback drains, and does nothing at all
+// when audio is not open. The callback plays it on a fixed pool of voices, stealing the
+// voice that has played the longest when all of them are busy.
+void postSound(SoundEvent event);
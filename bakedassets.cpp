@@ -0,0 +1,190 @@
+#include "bakedassets.h"
+#include <algorithm>
+#include <cstring>
+
+static const char sound_magic[4] = {'P', 'C', 'M', '0'};
+static const char image_magic[4] = {'I', 'M', 'G', '0'};
+static const char font_magic[4] = {'F', 'N', 'T', '0'};
+static const Uint32 baked_pixel_format = SDL_PIXELFORMAT_ARGB8888;
+static const int atlas_width = 512;
+
+bool bakeSound(const Mix_Chunk* chunk, int frequency, Uint16 format, int channels, SDL_RWops* out) {
+    BakedSound header{};
+    memcpy(header.magic, sound_magic, sizeof(header.magic));
+    header.frequency = (uint32_t)frequency;
+    header.format = format;
+    header.channels = (uint16_t)channels;
+    header.bytes = chunk->alen;
+    return SDL_RWwrite(out, &header, sizeof(header), 1) == 1 &&
+           SDL_RWwrite(out, chunk->abuf, 1, chunk->alen) == chunk->alen;
+}
+
+bool bakeImage(SDL_Surface* surface, SDL_RWops* out) {
+    SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, baked_pixel_format, 0);
+    if (!converted) return false;
+
+    BakedImage header{};
+    memcpy(header.magic, image_magic, sizeof(header.magic));
+    header.format = baked_pixel_format;
+    header.width = converted->w;
+    header.height = converted->h;
+    header.pitch = converted->pitch;
+    size_t bytes = (size_t)converted->pitch * converted->h;
+    bool ok = SDL_RWwrite(out, &header, sizeof(header), 1) == 1 &&
+              SDL_RWwrite(out, converted->pixels, 1, bytes) == bytes;
+    SDL_FreeSurface(converted);
+    return ok;
+}
+
+SDL_Surface* rasterizeFontAtlas(TTF_Font* font, int pointSize, BakedFont& header) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, font_magic, sizeof(header.magic));
+    header.pointSize = pointSize;
+    header.lineHeight = TTF_FontHeight(font);
+
+    // Render every glyph, then shelf-pack them left to right into fixed-width rows
+    const SDL_Color white = {255, 255, 255, 255};
+    SDL_Surface* glyphs[atlas_glyph_count] = {};
+    int x = 0, y = 0, rowHeight = 0;
+    for (int i = 0; i < atlas_glyph_count; ++i) {
+        Uint32 ch = atlas_first_glyph + i;
+        int advance = 0;
+        TTF_GlyphMetrics32(font, ch, nullptr, nullptr, nullptr, nullptr, &advance);
+        header.glyphs[i].advance = (int16_t)advance;
+
+        glyphs[i] = TTF_RenderGlyph32_Blended(font, ch, white);
+        if (!glyphs[i]) continue;
+        if (x + glyphs[i]->w > atlas_width) {
+            x = 0;
+            y += rowHeight + 1;
+            rowHeight = 0;
+        }
+        header.glyphs[i] = {(int16_t)x, (int16_t)y, (int16_t)glyphs[i]->w, (int16_t)glyphs[i]->h, (int16_t)advance, 0};
+        x += glyphs[i]->w + 1;
+        rowHeight = std::max(rowHeight, glyphs[i]->h);
+    }
+
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, atlas_width, std::max(y + rowHeight, 1), 32, baked_pixel_format);
+    if (atlas) {
+        SDL_FillRect(atlas, nullptr, 0);
+        for (int i = 0; i < atlas_glyph_count; ++i) {
+            if (!glyphs[i]) continue;
+            SDL_Rect dst = {header.glyphs[i].x, header.glyphs[i].y, header.glyphs[i].w, header.glyphs[i].h};
+            SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyphs[i], nullptr, atlas, &dst);
+        }
+        header.width = atlas->w;
+        header.height = atlas->h;
+        header.pitch = atlas->pitch;
+    }
+    for (auto* glyph : glyphs) {
+        if (glyph) SDL_FreeSurface(glyph);
+    }
+    return atlas;
+}
+
+bool bakeFont(TTF_Font* font, int pointSize, SDL_RWops* out) {
+    BakedFont header;
+    SDL_Surface* atlas = rasterizeFontAtlas(font, pointSize, header);
+    if (!atlas) return false;
+    size_t bytes = (size_t)atlas->pitch * atlas->h;
+    bool ok = SDL_RWwrite(out, &header, sizeof(header), 1) == 1 &&
+              SDL_RWwrite(out, atlas->pixels, 1, bytes) == bytes;
+    SDL_FreeSurface(atlas);
+    return ok;
+}
+
+const Uint8* bakedSoundPcm(const void* data, size_t size, Uint32* bytes) {
+    const BakedSound* header = static_cast<const BakedSound*>(data);
+    if (size < sizeof(BakedSound) || memcmp(header->magic, sound_magic, sizeof(sound_magic)) != 0 ||
+        size - sizeof(BakedSound) < header->bytes) {
+        SDL_SetError("Corrupt baked sound");
+        return nullptr;
+    }
+
+    // Only usable as-is when the device opened with the format it was baked for
+    int frequency = 0, channels = 0;
+    Uint16 format = 0;
+    if (!Mix_QuerySpec(&frequency, &format, &channels) || (uint32_t)frequency != header->frequency ||
+        format != header->format || channels != header->channels) {
+        SDL_SetError("Baked sound does not match the audio device format");
+        return nullptr;
+    }
+
+    *bytes = header->bytes;
+    return reinterpret_cast<const Uint8*>(header + 1);
+}
+
+Mix_Chunk* loadBakedSound(const void* data, size_t size) {
+    Uint32 bytes = 0;
+    const Uint8* pcm = bakedSoundPcm(data, size, &bytes);
+    if (!pcm) return nullptr;
+
+    // QuickLoad wraps the buffer without copying it, and the mixer never writes to it
+    return Mix_QuickLoad_RAW(const_cast<Uint8*>(pcm), bytes);
+}
+
+SDL_Texture* loadBakedImage(SDL_Renderer* renderer, const void* data, size_t size) {
+    const BakedImage* header = static_cast<const BakedImage*>(data);
+    if (size < sizeof(BakedImage) || memcmp(header->magic, image_magic, sizeof(image_magic)) != 0 ||
+        size - sizeof(BakedImage) < (size_t)header->pitch * header->height) {
+        SDL_SetError("Corrupt baked image");
+        return nullptr;
+    }
+
+    SDL_Texture* texture = SDL_CreateTexture(renderer, header->format, SDL_TEXTUREACCESS_STATIC, header->width, header->height);
+    if (texture && SDL_UpdateTexture(texture, nullptr, header + 1, header->pitch) != 0) {
+        SDL_DestroyTexture(texture);
+        return nullptr;
+    }
+    return texture;
+}
+
+bool loadBakedFont(SDL_Renderer* renderer, const void* data, size_t size, FontAtlas& atlas) {
+    const BakedFont* header = static_cast<const BakedFont*>(data);
+    if (size < sizeof(BakedFont) || memcmp(header->magic, font_magic, sizeof(font_magic)) != 0 ||
+        size - sizeof(BakedFont) < (size_t)header->pitch * header->height) {
+        SDL_SetError("Corrupt baked font");
+        return false;
+    }
+    if (header->pointSize != atlas_point_size) {
+        SDL_SetError("Baked font is %d pt, expected %d pt", header->pointSize, atlas_point_size);
+        return false;
+    }
+    return createFontAtlas(renderer, *header, header + 1, atlas);
+}
+
+bool createFontAtlas(SDL_Renderer* renderer, const BakedFont& header, const void* pixels, FontAtlas& atlas) {
+    atlas.texture = SDL_CreateTexture(renderer, baked_pixel_format, SDL_TEXTUREACCESS_STATIC, header.width, header.height);
+    if (!atlas.texture) return false;
+    SDL_UpdateTexture(atlas.texture, nullptr, pixels, header.pitch);
+    SDL_SetTextureBlendMode(atlas.texture, SDL_BLENDMODE_BLEND);
+    atlas.lineHeight = header.lineHeight;
+    memcpy(atlas.glyphs, header.glyphs, sizeof(atlas.glyphs));
+    return true;
+}
+
+int textWidth(const FontAtlas& atlas, const char* text) {
+    int width = 0;
+    for (const char* c = text; *c; ++c) {
+        int index = (unsigned char)*c - atlas_first_glyph;
+        if (index >= 0 && index < atlas_glyph_count) width += atlas.glyphs[index].advance;
+    }
+    return width;
+}
+
+void drawText(SDL_Renderer* renderer, const FontAtlas& atlas, const char* text, int x, int y, SDL_Color color) {
+    SDL_SetTextureColorMod(atlas.texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(atlas.texture, color.a);
+    for (const char* c = text; *c; ++c) {
+        int index = (unsigned char)*c - atlas_first_glyph;
+        if (index < 0 || index >= atlas_glyph_count) continue;
+        const BakedGlyph& glyph = atlas.glyphs[index];
+        if (glyph.w > 0) {
+            SDL_Rect src = {glyph.x, glyph.y, glyph.w, glyph.h};
+            SDL_Rect dst = {x, y, glyph.w, glyph.h};
+            SDL_RenderCopy(renderer, atlas.texture, &src, &dst);
+        }
+        x += glyph.advance;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <SDL2/SDL_ttf.h>
+
+// Pre-decoded asset formats written by baker.cpp (make bake). A baked blob is one of
+// the headers below followed directly by its payload, and is used in place straight
+// out of the memory-mapped asset pack. Baked assets are named after their source with
+// an extra extension: ".pcm" for sounds, ".img" for images, ".atlas" for fonts.
+
+const int atlas_point_size = 24;
+const int atlas_first_glyph = 32;
+const int atlas_glyph_count = 95;
+
+// Raw PCM in the mixer's output format
+struct BakedSound {
+    char magic[4];
+    uint32_t frequency;
+    uint16_t format;
+    uint16_t channels;
+    uint32_t bytes;
+};
+
+// Pixels in a texture format the renderers take without conversion
+struct BakedImage {
+    char magic[4];
+    uint32_t format;
+    int32_t width;
+    int32_t height;
+    int32_t pitch;
+};
+
+struct BakedGlyph {
+    int16_t x, y, w, h;
+    int16_t advance;
+    int16_t reserved;
+};
+
+// White, alpha-blended glyphs for the printable ASCII range packed into one ARGB8888 atlas
+struct BakedFont {
+    char magic[4];
+    int32_t pointSize;
+    int32_t lineHeight;
+    int32_t width;
+    int32_t height;
+    int32_t pitch;
+    BakedGlyph glyphs[atlas_glyph_count];
+};
+
+struct FontAtlas {
+    SDL_Texture* texture = nullptr;
+    int lineHeight = 0;
+    BakedGlyph glyphs[atlas_glyph_count] = {};
+};
+
+// Baking (CPU only, safe on worker threads)
+bool bakeSound(const Mix_Chunk* chunk, int frequency, Uint16 format, int channels, SDL_RWops* out);
+bool bakeImage(SDL_Surface* surface, SDL_RWops* out);
+SDL_Surface* rasterizeFontAtlas(TTF_Font* font, int pointSize, BakedFont& header);
+bool bakeFont(TTF_Font* font, int pointSize, SDL_RWops* out);
+
+// Loading. Sounds can be loaded anywhere; anything that creates a texture has to run on the render thread.
+const Uint8* bakedSoundPcm(const void* data, size_t size, Uint32* bytes);
+Mix_Chunk* loadBakedSound(const void* data, size_t size);
+SDL_Texture* loadBakedImage(SDL_Renderer* renderer, const void* data, size_t size);
+bool loadBakedFont(SDL_Renderer* renderer, const void* data, size_t size, FontAtlas& atlas);
+bool createFontAtlas(SDL_Renderer* renderer, const BakedFont& header, const void* pixels, FontAtlas& atlas);
+
+// Text drawing from an atlas
+int textWidth(const FontAtlas& atlas, const char* text);
+void drawText(SDL_Renderer* renderer, const FontAtlas& atlas, const char* text, int x, int y, SDL_Color color);
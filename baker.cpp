@@ -0,0 +1,92 @@
+#include <bits/stdc++.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_mixer.h>
+#include "audio.h"
+#include "bakedassets.h"
+using namespace std;
+
+// Build-time tool: decodes assets once into the formats the game uses directly.
+// Usage: baker <output dir> <asset>...
+//   .mp3/.wav/.ogg -> <name>.pcm    PCM in the mixer output format from audio.h
+//   .bmp/.png      -> <name>.img    ARGB8888 pixels
+//   .ttf           -> <name>.atlas  glyph atlas at atlas_point_size
+
+bool endsWith(const string& text, const string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <output dir> <asset>..." << endl;
+        return 1;
+    }
+
+    // No sound is played, but the mixer needs an open device to convert into its format
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    if (SDL_Init(SDL_INIT_AUDIO) != 0 || TTF_Init() != 0 || Mix_OpenAudioDevice(audio_frequency, AUDIO_S16SYS, audio_channels, audio_max_buffer, nullptr, 0) < 0) {
+        cerr << "Initialization failed: " << SDL_GetError() << endl;
+        return 1;
+    }
+    int frequency = 0, channels = 0;
+    Uint16 format = 0;
+    Mix_QuerySpec(&frequency, &format, &channels);
+
+    filesystem::create_directories(argv[1]);
+
+    int failures = 0;
+    for (int i = 2; i < argc; ++i) {
+        string source = argv[i];
+        string name = filesystem::path(source).filename().string();
+        string lower = name;
+        transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+        string suffix;
+        if (endsWith(lower, ".mp3") || endsWith(lower, ".wav") || endsWith(lower, ".ogg")) suffix = ".pcm";
+        else if (endsWith(lower, ".bmp") || endsWith(lower, ".png")) suffix = ".img";
+        else if (endsWith(lower, ".ttf")) suffix = ".atlas";
+        else {
+            cerr << "Don't know how to bake " << source << endl;
+            ++failures;
+            continue;
+        }
+
+        string target = (filesystem::path(argv[1]) / (name + suffix)).string();
+        SDL_RWops* out = SDL_RWFromFile(target.c_str(), "wb");
+        if (!out) {
+            cerr << "Failed to create " << target << ": " << SDL_GetError() << endl;
+            ++failures;
+            continue;
+        }
+
+        bool ok = false;
+        if (suffix == ".pcm") {
+            Mix_Chunk* chunk = Mix_LoadWAV(source.c_str());
+            ok = chunk && bakeSound(chunk, frequency, format, channels, out);
+            if (chunk) Mix_FreeChunk(chunk);
+        } else if (suffix == ".img") {
+            SDL_Surface* surface = IMG_Load(source.c_str());
+            ok = surface && bakeImage(surface, out);
+            if (surface) SDL_FreeSurface(surface);
+        } else {
+            TTF_Font* font = TTF_OpenFont(source.c_str(), atlas_point_size);
+            ok = font && bakeFont(font, atlas_point_size, out);
+            if (font) TTF_CloseFont(font);
+        }
+        SDL_RWclose(out);
+
+        if (ok) {
+            cout << "Baked " << source << " -> " << target << endl;
+        } else {
+            cerr << "Failed to bake " << source << ": " << SDL_GetError() << endl;
+            remove(target.c_str());
+            ++failures;
+        }
+    }
+
+    Mix_CloseAudio();
+    TTF_Quit();
+    SDL_Quit();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+#include "beam.h"
+#include <algorithm>
+#include "config.h"
+using namespace std;
+
+double BeamSearch::foodHeuristic(const GameState& position, const GameState& root) {
+    if (position.won) return 1e12;
+    if (!position.alive) return -1e12 + (double)position.ticks;
+    const SnakeSegment head = position.snake.front();
+    int distance = position.food.x >= 0 ? wrappedDistance(head, position.food) : 0;
+    if (position.bonusFoodActive) distance = min(distance, wrappedDistance(head, position.bonusFood));
+    return (position.score - root.score) * 1000.0 - distance;
+}
+
+SDL_Keycode BeamSearch::plan(const GameState& game) {
+    const Config& settings = config();
+    const int width = settings.beamWidth;
+    if ((int)beam.size() < width) {
+        beam.resize(width);
+        beamMove.resize(width);
+        successors.resize(width * 3);
+        successorMove.resize(width * 3);
+        scores.resize(width * 3);
+        ranking.resize(width * 3);
+        size_t slots = 1;
+        while (slots < (size_t)width * 6) slots *= 2;
+        seen.assign(slots, 0);
+        seenPly.assign(slots, 0);
+        plyStamp = 0;
+    }
+    const size_t seenMask = seen.size() - 1;
+    auto firstVisit = [&](uint64_t hash) {
+        size_t slot = hash & seenMask;
+        for (; seenPly[slot] == plyStamp; slot = (slot + 1) & seenMask) {
+            if (seen[slot] == hash) return false;
+        }
+        seenPly[slot] = plyStamp;
+        seen[slot] = hash;
+        return true;
+    };
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const Uint64 budget = settings.searchBudgetMs * SDL_GetPerformanceFrequency() / 1000;
+    Uint64 plyStart = start;
+
+    beam[0] = game;
+    beam[0].muted = true;
+    beam[0].rng = (game.rng ^ 0xD1B54A32D192ED03ull) | 1;
+    int beamSize = 1;
+    SDL_Keycode best = 0;
+    lastDepth = 0;
+
+    for (int ply = 0; ply < settings.beamDepth; ++ply) {
+        if (++plyStamp == 0) {
+            fill(seenPly.begin(), seenPly.end(), 0);
+            plyStamp = 1;
+        }
+
+        // Expand the whole beam into one batch of successors, skipping moves that die
+        int count = 0;
+        for (int b = 0; b < beamSize; ++b) {
+            const GameState& position = beam[b];
+            const SDL_Keycode reverse = oppositeDirection(position.direction);
+            for (int m = 0; m < 4; ++m) {
+                if (move_directions[m] == reverse) continue;
+                const SnakeSegment next = step(position.snake.front(), move_directions[m]);
+                if (checkCollision(position, next.x, next.y)) continue;
+                GameState& successor = successors[count];
+                successor = position;
+                turn(successor, move_directions[m]);
+                update(successor);
+                if (!firstVisit(successor.hash)) continue;
+                successorMove[count] = ply == 0 ? (uint8_t)m : beamMove[b];
+                ranking[count] = count;
+                ++count;
+            }
+        }
+        if (count == 0) break;
+        for (int i = 0; i < count; ++i) scores[i] = heuristic(successors[i], game);
+
+        // Keep the best; swapping moves the positions' buffers instead of copying them
+        const int keep = min(count, width);
+        partial_sort(ranking.begin(), ranking.begin() + keep, ranking.begin() + count,
+                     [this](int a, int b) { return scores[a] > scores[b]; });
+        for (int i = 0; i < keep; ++i) {
+            swap(beam[i], successors[ranking[i]]);
+            beamMove[i] = successorMove[ranking[i]];
+        }
+        beamSize = keep;
+        best = move_directions[beamMove[0]];
+        lastDepth = ply + 1;
+        if (beam[0].won) break;
+
+        // Don't start a ply that would likely overrun the budget
+        const Uint64 now = SDL_GetPerformanceCounter();
+        if (2 * now - plyStart - start > budget) break;
+        plyStart = now;
+    }
+    return best;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "game.h"
+
+// Beam search: keeps the config().beamWidth best positions and expands them a ply at
+// a time, up to config().beamDepth plies ahead. Each ply copies every position in the
+// beam once per safe move into one flat batch, runs update() on the batch, drops
+// positions another path already reached (by hash), scores the rest with the
+// heuristic and keeps the best. The arrays are sized on the first plan and reused, so
+// planning copies positions but allocates nothing. A ply that would run past
+// config().searchBudgetMs isn't started, so the planner fits a fixed budget per tick.
+//
+// Food eaten in the lookahead respawns from a generator of the planner's own, as the
+// real spawn can't be known in advance.
+class BeamSearch {
+public:
+    // Scores a position reached from root; higher is better
+    typedef double (*Heuristic)(const GameState& position, const GameState& root);
+
+    // Prefers eating, then being near food, and dying as late as possible
+    static double foodHeuristic(const GameState& position, const GameState& root);
+
+    explicit BeamSearch(Heuristic heuristic = foodHeuristic) : heuristic(heuristic) {}
+
+    // First move towards the best position found, or 0 when every move dies at once
+    SDL_Keycode plan(const GameState& game);
+
+    // Plies the last plan() got through
+    int depthReached() const { return lastDepth; }
+
+private:
+    Heuristic heuristic;
+    std::vector<GameState> beam;       // Positions kept at the current ply
+    std::vector<GameState> successors; // Every expansion of the current ply
+    std::vector<uint8_t> beamMove;     // First move that led to each beam position
+    std::vector<uint8_t> successorMove;
+    std::vector<double> scores;
+    std::vector<int> ranking;          // Successor indices, best first after selection
+    std::vector<uint64_t> seen;        // Open-addressed set of this ply's hashes
+    std::vector<uint32_t> seenPly;     // Which plan and ply each slot of seen belongs to
+    uint32_t plyStamp = 0;
+    int lastDepth = 0;
+};
@@ -0,0 +1,76 @@
+#include "bot.h"
+#include "config.h"
+#include "metrics.h"
+using namespace std;
+
+SDL_Keycode greedyMove(const GameState& game) {
+    const SnakeSegment head = game.snake.front();
+    SDL_Point target = game.food;
+    if (game.bonusFoodActive && wrappedDistance(head, game.bonusFood) < wrappedDistance(head, game.food)) {
+        target = game.bonusFood;
+    }
+
+    SDL_Keycode best = game.direction;
+    int bestDistance = -1;
+    for (SDL_Keycode direction : move_directions) {
+        if (direction == oppositeDirection(game.direction)) continue;
+        SnakeSegment next = step(head, direction);
+        if (checkCollision(game, next.x, next.y)) continue;
+        int distance = wrappedDistance(next, target);
+        if (bestDistance < 0 || distance < bestDistance) {
+            best = direction;
+            bestDistance = distance;
+        }
+    }
+    return best;
+}
+
+SDL_Keycode Autopilot::move(const GameState& game) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    SDL_Keycode direction = 0;
+    switch (bot) {
+        case Bot::Path: direction = pathFinder.plan(game); break;
+        case Bot::Hamiltonian: direction = hamiltonian.plan(game); break;
+        case Bot::Mcts: direction = mcts.plan(game); break;
+        case Bot::Beam: direction = beam.plan(game); break;
+        case Bot::Neural: direction = neural.move(game); break;
+        case Bot::Greedy:
+        case Bot::Count: break;
+    }
+    if (!direction) direction = greedyMove(game);
+    if (bot != Bot::Hamiltonian) direction = avoidTraps(game, direction);
+    metrics.autopilotPlan.record((SDL_GetPerformanceCounter() - start) * 1e6 / SDL_GetPerformanceFrequency());
+    return direction;
+}
+
+void Autopilot::moves(const GameState* const* games, int count, SDL_Keycode* directions) {
+    if (bot != Bot::Neural) {
+        for (int i = 0; i < count; ++i) directions[i] = move(*games[i]);
+        return;
+    }
+    Uint64 start = SDL_GetPerformanceCounter();
+    neural.moves(games, count, directions);
+    for (int i = 0; i < count; ++i) {
+        if (!directions[i]) directions[i] = greedyMove(*games[i]);
+        directions[i] = avoidTraps(*games[i], directions[i]);
+    }
+    const double micros = (SDL_GetPerformanceCounter() - start) * 1e6 / SDL_GetPerformanceFrequency() / count;
+    for (int i = 0; i < count; ++i) metrics.autopilotPlan.record(micros);
+}
+
+SDL_Keycode Autopilot::avoidTraps(const GameState& game, SDL_Keycode direction) {
+    Reach reach[4];
+    if (!floodFill.measure(game, reach)) return direction;
+
+    const int length = (int)game.snake.size();
+    int chosen = 0;
+    while (move_directions[chosen] != direction) ++chosen;
+    if (reach[chosen].tail || reach[chosen].cells >= length) return direction;
+
+    // Following the tail always works out; otherwise the more room the better
+    for (int m = 0; m < 4; ++m) {
+        if (reach[m].cells == 0) continue;
+        if (reach[m].tail != reach[chosen].tail ? reach[m].tail : reach[m].cells > reach[chosen].cells) chosen = m;
+    }
+    return move_directions[chosen];
+}
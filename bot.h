@@ -0,0 +1,47 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include "beam.h"
+#include "botkind.h"
+#include "floodfill.h"
+#include "game.h"
+#include "hamiltonian.h"
+#include "mcts.h"
+#include "pathfinder.h"
+#include "policy.h"
+
+// Picks the next heading for the snake. The greedy bot heads for the nearest food on
+// the wrapped board and only steers clear of moves that die on the very next tick.
+SDL_Keycode greedyMove(const GameState& game);
+
+// Drives a game with one of the bots. Keeps the bot's scratch buffers between moves, so
+// use one per thread, and reset() it before the thread starts another game. Records how
+// long each move took to plan in metrics. Every bot but the Hamiltonian one has its
+// move checked with a flood fill, and a move into a pocket the snake can neither fit in
+// nor follow its tail out of is swapped for the roomiest move that isn't one.
+class Autopilot {
+public:
+    // searchThreads is passed to MctsPlanner
+    explicit Autopilot(Bot bot, unsigned searchThreads = 0) : bot(bot), mcts(searchThreads) {}
+    SDL_Keycode move(const GameState& game);
+
+    // Moves for several games at once. The neural bot runs them through its network
+    // as one batch; the others plan each in turn.
+    void moves(const GameState* const* games, int count, SDL_Keycode* directions);
+
+    // Drops what the search learnt in the last game, keeping the buffers
+    void reset() {
+        pathFinder.clear();
+        mcts.clear();
+    }
+
+private:
+    SDL_Keycode avoidTraps(const GameState& game, SDL_Keycode direction);
+
+    Bot bot;
+    PathFinder pathFinder;
+    HamiltonianSolver hamiltonian;
+    MctsPlanner mcts;
+    BeamSearch beam;
+    NeuralPolicy neural;
+    FloodFill floodFill;
+};
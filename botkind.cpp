@@ -0,0 +1,23 @@
+#include "botkind.h"
+#include <cstring>
+using namespace std;
+
+namespace {
+
+const char* names[bot_count] = {"greedy", "path", "hamiltonian", "mcts", "beam", "neural"};
+
+} // namespace
+
+const char* botName(Bot bot) {
+    return names[(int)bot];
+}
+
+bool parseBot(const char* name, Bot& result) {
+    for (int i = 0; i < bot_count; ++i) {
+        if (strcmp(name, names[i]) == 0) {
+            result = Bot(i);
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+// Which bot drives the autopilot, kept apart from bot.h so config.h can name one
+// without pulling in the game and every planner.
+//
+// Bots the autopilot can drive with:
+//   greedy       greedyMove() in bot.h
+//   path         shortest safe path to food (PathFinder), greedy when there is none
+//   hamiltonian  follows a cycle through every free cell (HamiltonianSolver), and
+//                fills the board
+//   mcts         parallel Monte Carlo tree search (MctsPlanner)
+//   beam         beam search lookahead (BeamSearch)
+//   neural       policy network in config().policy (NeuralPolicy), greedy when it
+//                can't be loaded
+enum class Bot {
+    Greedy,
+    Path,
+    Hamiltonian,
+    Mcts,
+    Beam,
+    Neural,
+    Count
+};
+const int bot_count = (int)Bot::Count;
+
+const char* botName(Bot bot);
+bool parseBot(const char* name, Bot& result);
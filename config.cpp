@@ -0,0 +1,231 @@
+#include "config.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+using namespace std;
+
+namespace {
+
+Config loaded;
+
+bool parseInt(const string& value, int& result) {
+    char* end = nullptr;
+    long parsed = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') return false;
+    result = (int)parsed;
+    return true;
+}
+
+bool parseSeed(const string& value, uint64_t& result) {
+    char* end = nullptr;
+    unsigned long long parsed = strtoull(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0') return false;
+    result = parsed;
+    return true;
+}
+
+bool parseBool(const string& value, bool& result) {
+    if (value == "true" || value == "yes" || value == "1") result = true;
+    else if (value == "false" || value == "no" || value == "0") result = false;
+    else return false;
+    return true;
+}
+
+string trim(const string& text) {
+    size_t begin = text.find_first_not_of(" \t\r");
+    if (begin == string::npos) return "";
+    size_t end = text.find_last_not_of(" \t\r");
+    return text.substr(begin, end - begin + 1);
+}
+
+// "greedy,path" and so on; each bot at most once
+bool parseBots(const string& value, vector<Bot>& result) {
+    vector<Bot> bots;
+    istringstream in(value);
+    string name;
+    while (getline(in, name, ',')) {
+        Bot bot;
+        if (!parseBot(trim(name).c_str(), bot) || find(bots.begin(), bots.end(), bot) != bots.end()) return false;
+        bots.push_back(bot);
+    }
+    if (bots.empty()) return false;
+    result = bots;
+    return true;
+}
+
+// The first obstacle given replaces the built-in layout; later ones add to it
+bool obstaclesReplaced = false;
+
+bool applySetting(Config& config, const string& key, const string& value) {
+    if (key == "screen_width") return parseInt(value, config.screenWidth);
+    if (key == "screen_height") return parseInt(value, config.screenHeight);
+    if (key == "block_size") return parseInt(value, config.blockSize);
+    if (key == "tick_ms") return parseInt(value, config.tickMs);
+    if (key == "audio") return parseBool(value, config.audio);
+    if (key == "audio_buffer") return parseInt(value, config.audioBuffer);
+    if (key == "music_lookahead") return parseInt(value, config.musicLookaheadMs);
+    if (key == "pacing") return parsePacing(value.c_str(), config.pacing);
+    if (key == "seed") return parseSeed(value, config.seed);
+    if (key == "bot") return parseBot(value.c_str(), config.bot);
+    if (key == "autopilot") return parseBool(value, config.autopilot);
+    if (key == "search_budget_ms") return parseInt(value, config.searchBudgetMs);
+    if (key == "search_threads") return parseInt(value, config.searchThreads);
+    if (key == "table_mb") return parseInt(value, config.tableMb);
+    if (key == "beam_width") return parseInt(value, config.beamWidth);
+    if (key == "beam_depth") return parseInt(value, config.beamDepth);
+    if (key == "population") return parseInt(value, config.population);
+    if (key == "generations") return parseInt(value, config.generations);
+    if (key == "train_games") return parseInt(value, config.trainGames);
+    if (key == "train_hidden") return parseInt(value, config.trainHidden);
+    if (key == "checkpoint_every") return parseInt(value, config.checkpointEvery);
+    if (key == "tournament_bots") return parseBots(value, config.tournamentBots);
+    if (key == "games") return parseInt(value, config.games);
+    if (key == "max_ticks") return parseInt(value, config.maxTicks);
+    if (key == "script") config.script = value;
+    else if (key == "policy") config.policy = value;
+    else if (key == "results") config.results = value;
+    else if (key == "asset_pack") config.assetPack = value;
+    else if (key == "font") config.font = value;
+    else if (key == "background") config.background = value;
+    else if (key == "music") config.music = value;
+    else if (key == "eat_sound") config.eatSound = value;
+    else if (key == "game_over_sound") config.gameOverSound = value;
+    else if (key == "obstacle" && value == "none") {
+        config.obstacles.clear();
+        obstaclesReplaced = true;
+    } else if (key == "obstacle") {
+        SDL_Rect rect;
+        istringstream in(value);
+        if (!(in >> rect.x >> rect.y >> rect.w >> rect.h)) return false;
+        if (!obstaclesReplaced) config.obstacles.clear();
+        obstaclesReplaced = true;
+        config.obstacles.push_back(rect);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool loadFile(Config& config, const char* path, bool required) {
+    ifstream file(path);
+    if (!file) {
+        if (required) cerr << "Failed to open config file " << path << endl;
+        return !required;
+    }
+
+    string line;
+    for (int number = 1; getline(file, line); ++number) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+        size_t equals = line.find('=');
+        if (equals == string::npos || !applySetting(config, trim(line.substr(0, equals)), trim(line.substr(equals + 1)))) {
+            cerr << path << ":" << number << ": bad setting: " << line << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool derive(Config& config) {
+    if (config.blockSize <= 0 || config.tickMs <= 0 || config.games <= 0 || config.maxTicks <= 0 || config.searchBudgetMs <= 0 ||
+        config.tableMb <= 0 || config.beamWidth <= 0 || config.beamDepth <= 0) {
+        cerr << "block_size, tick_ms, games, max_ticks, search_budget_ms, table_mb, beam_width and beam_depth must be positive"
+             << endl;
+        return false;
+    }
+    if (config.population < 2 || config.generations <= 0 || config.trainGames <= 0 || config.trainHidden <= 0 ||
+        config.checkpointEvery <= 0) {
+        cerr << "population must be at least 2, and generations, train_games, train_hidden and checkpoint_every positive"
+             << endl;
+        return false;
+    }
+    if (config.tournament && config.tournamentBots.size() < 2) {
+        cerr << "A tournament needs at least two bots" << endl;
+        return false;
+    }
+    if (config.searchThreads < 0) {
+        cerr << "search_threads can't be negative" << endl;
+        return false;
+    }
+    config.gridWidth = config.screenWidth / config.blockSize;
+    config.gridHeight = config.screenHeight / config.blockSize;
+    if (config.gridWidth < 4 || config.gridHeight < 4) {
+        cerr << "The board must be at least 4x4 cells" << endl;
+        return false;
+    }
+
+    config.obstacleMask.assign(config.gridWidth * config.gridHeight, 0);
+    for (int y = 0; y < config.gridHeight; ++y) {
+        for (int x = 0; x < config.gridWidth; ++x) {
+            SDL_Rect cell = {x * config.blockSize, y * config.blockSize, config.blockSize, config.blockSize};
+            for (const SDL_Rect& obstacle : config.obstacles) {
+                if (SDL_HasIntersection(&cell, &obstacle)) config.obstacleMask[y * config.gridWidth + x] = 1;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool loadConfig(int argc, char* argv[]) {
+    const char* path = default_config_path;
+    bool pathGiven = false;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--config") == 0) {
+            path = argv[i + 1];
+            pathGiven = true;
+        }
+    }
+
+    Config config;
+    if (!loadFile(config, path, pathGiven)) return false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--config") == 0) ++i;
+        else if (strcmp(arg, "--no-audio") == 0) config.audio = false;
+        else if (strcmp(arg, "--bench") == 0) {
+            config.audio = false;
+            config.pacing = Pacing::Uncapped;
+        }
+        else if (strcmp(arg, "--bench-startup") == 0) config.benchStartup = true;
+        else if (strcmp(arg, "--idle-check") == 0) config.idleCheck = true;
+        else if (strcmp(arg, "--latency-test") == 0) config.latencyTest = true;
+        else if (strcmp(arg, "--headless") == 0) config.headless = true;
+        else if (strcmp(arg, "--hash-check") == 0) config.headless = config.hashCheck = true;
+        else if (strcmp(arg, "--fill-check") == 0) {
+            config.headless = config.fillCheck = true;
+            config.bot = Bot::Hamiltonian;
+        }
+        else if (strcmp(arg, "--nn-bench") == 0) config.nnBench = true;
+        else if (strcmp(arg, "--train") == 0) config.train = true;
+        else if (strcmp(arg, "--tournament") == 0) config.tournament = true;
+        else if (strcmp(arg, "--autopilot") == 0) config.autopilot = true;
+        else if (strncmp(arg, "--", 2) == 0 && i + 1 < argc) {
+            // --music-lookahead 250 sets music_lookahead, and so on
+            string key = arg + 2;
+            for (char& c : key) {
+                if (c == '-') c = '_';
+            }
+            if (!applySetting(config, key, argv[++i])) {
+                cerr << "Bad setting: " << arg << " " << argv[i] << endl;
+                return false;
+            }
+        } else {
+            cerr << "Unknown argument: " << arg << endl;
+            return false;
+        }
+    }
+
+    if (!derive(config)) return false;
+    loaded = move(config);
+    return true;
+}
+
+const Config& config() {
+    return loaded;
+}
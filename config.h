@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "botkind.h"
+#include "musicstream.h"
+#include "pacingmode.h"
+
+const char* const default_config_path = "snake.cfg";
+
+// Settings, read once at startup from a key = value file (snake.cfg, or --config path)
+// and then the command line, which wins: --key value for any file key, plus the flags
+// below. Nothing writes to it afterwards. Whatever the tick needs is derived up front,
+// so the grid size is a field and an obstacle check is one byte load.
+struct Config {
+    // Board
+    int screenWidth = 700;
+    int screenHeight = 500;
+    int blockSize = 20;
+    int tickMs = 100;
+    // "obstacle = x y w h" per rectangle, or "obstacle = none" for an open board
+    std::vector<SDL_Rect> obstacles = {{100, 120, 200, 20}, {420, 360, 200, 20}, {300, 240, 100, 20}};
+
+    // Audio
+    bool audio = true;
+    int audioBuffer = 0; // Samples; 0 sizes it automatically
+    int musicLookaheadMs = music_default_lookahead_ms;
+
+    // Presentation
+    Pacing pacing = Pacing::Vsync;
+
+    // Assets, by name inside the pack or as files next to the game
+    std::string assetPack = "assets.pak";
+    std::string font = "arial.ttf";
+    std::string background = "47412.bmp";
+    std::string music = "audio.mp3";
+    std::string eatSound = "eating-sound-effect-36186.mp3";
+    std::string gameOverSound = "game-over-arcade-6435.mp3";
+
+    // Games. A seed of 0 picks a fresh one from the clock for every game.
+    uint64_t seed = 0;
+
+    // Autopilot: which bot plays, and whether it starts in control (A toggles it)
+    Bot bot = Bot::Path;
+    bool autopilot = false;
+
+    // Search bots: thinking time per move, how many threads share it (0 for one per
+    // core) and the size of their transposition table. Keep the budget well under
+    // tick_ms when the autopilot plays live.
+    int searchBudgetMs = 5;
+    int searchThreads = 0;
+    int tableMb = 16;
+    int beamWidth = 64;
+    int beamDepth = 16;
+
+    // Neural bot: its weights file (see network.h)
+    std::string policy = "policy.snn";
+
+    // Training the neural bot (--train): policies per generation, how many
+    // generations, the games each policy plays per generation, the hidden layer's
+    // size and how often to keep a numbered checkpoint
+    int population = 64;
+    int generations = 20;
+    int trainGames = 16;
+    int trainHidden = 32;
+    int checkpointEvery = 5;
+
+    // Tournaments (--tournament): which bots take part, as a comma-separated list of
+    // names, and a CSV file for the results table (none when empty)
+    std::vector<Bot> tournamentBots = {Bot::Greedy, Bot::Path, Bot::Hamiltonian, Bot::Mcts, Bot::Beam, Bot::Neural};
+    std::string results;
+
+    // Headless runs: how many games, where their input comes from (a script file, or
+    // the configured bot when empty) and when to give up on a game that doesn't end
+    int games = 1;
+    std::string script;
+    int maxTicks = 100000;
+
+    // Run modes (command line only)
+    bool benchStartup = false;
+    bool idleCheck = false;
+    bool latencyTest = false;
+    bool headless = false;
+    bool hashCheck = false;
+    bool fillCheck = false;
+    bool nnBench = false;
+    bool train = false;
+    bool tournament = false;
+
+    // Derived
+    int gridWidth = 0;
+    int gridHeight = 0;
+    std::vector<Uint8> obstacleMask; // gridWidth * gridHeight, 1 where a cell touches an obstacle
+
+    bool blocked(int x, int y) const { return obstacleMask[y * gridWidth + x]; }
+};
+
+// Loads the config, printing what was wrong and returning false on a bad file or
+// argument. Must be called once, before anything reads config().
+//   --config path     read this file instead of snake.cfg
+//   --no-audio        audio = false
+//   --bench           no audio and uncapped pacing, for benchmarks
+//   --autopilot       autopilot = true
+//   --headless        run games with no window or audio (see headless.h)
+//   --hash-check      headless, checking the engine's incremental hash every tick
+//   --fill-check      headless with the Hamiltonian bot, which must fill every board
+//                     in well under a second of CPU per game
+//   --nn-bench        check and time the neural bot's network kernels (see policy.h)
+//   --train           evolve weights for the neural bot (see trainer.h)
+//   --tournament      rate the bots against each other (see tournament.h)
+//   --bench-startup, --idle-check, --latency-test
+bool loadConfig(int argc, char* argv[]);
+const Config& config();
@@ -0,0 +1,14 @@
+#pragma once
+#include <chrono>
+#include <thread>
+
+// How close to a deadline waitUntil() stops sleeping and starts yielding
+const auto spin_window = std::chrono::microseconds(1500);
+
+// Sleeps most of the way to the deadline, then yields through the last stretch so the
+// wait ends within microseconds of it instead of wherever the scheduler wakes us. The
+// simulation's ticks and the renderer's frame deadlines both wait with it.
+inline void waitUntil(std::chrono::steady_clock::time_point deadline) {
+    if (deadline - std::chrono::steady_clock::now() > spin_window) std::this_thread::sleep_until(deadline - spin_window);
+    while (std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+}
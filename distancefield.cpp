@@ -0,0 +1,73 @@
+#include "distancefield.h"
+#include <algorithm>
+#include "config.h"
+using namespace std;
+
+namespace {
+
+// Cells a search takes out of its queue per update(), across both fields. A few
+// microseconds of work; the default board fills in two updates.
+const int cells_per_update = 512;
+
+bool samePoint(SDL_Point a, SDL_Point b) {
+    return a.x == b.x && a.y == b.y;
+}
+
+} // namespace
+
+void DistanceField::Spread::start(SDL_Point at, const Uint8* obstacles) {
+    source = at;
+    queue.clear();
+    next = 0;
+    if (at.x < 0) return;
+    cells.assign(config().obstacleMask.size(), unreachable);
+    const int cell = at.y * config().gridWidth + at.x;
+    if (obstacles[cell]) return;
+    cells[cell] = 0;
+    queue.push_back(cell);
+}
+
+// Breadth-first from the queue, reaching the neighbours of up to limit cells. Returns
+// how many it took.
+int DistanceField::Spread::advance(int limit, const Uint8* obstacles) {
+    const int* neighbours = neighbourCells().data();
+    int taken = 0;
+    for (; next < queue.size() && taken < limit; ++next, ++taken) {
+        const int cell = queue[next];
+        const uint16_t reached = cells[cell] + 1;
+        for (int m = 0; m < 4; ++m) {
+            const int neighbour = neighbours[cell * 4 + m];
+            if (obstacles[neighbour] || cells[neighbour] != unreachable) continue;
+            cells[neighbour] = reached;
+            queue.push_back(neighbour);
+        }
+    }
+    return taken;
+}
+
+// A reached cell's distance is final. Every cell nearer than the next one the search
+// takes has been reached, so one it hasn't is at least a move further than that.
+uint16_t DistanceField::Spread::estimate(int cell, int width) const {
+    if (source.x < 0) return unreachable;
+    const uint16_t distance = cells[cell];
+    if (distance != unreachable || done()) return distance;
+    const int straight = wrappedDistance({cell % width, cell / width}, source);
+    return (uint16_t)max(cells[queue[next]] + 1, straight);
+}
+
+void DistanceField::update(const GameState& game) {
+    const Config& settings = config();
+    const Uint8* obstacles = settings.obstacleMask.data();
+    const SDL_Point wantedBonus = game.bonusFoodActive ? game.bonusFood : SDL_Point{-1, -1};
+    if (board != obstacles || width != settings.gridWidth) {
+        board = obstacles;
+        width = settings.gridWidth;
+        food.start(game.food, obstacles);
+        bonus.start(wantedBonus, obstacles);
+    }
+    if (!samePoint(food.source, game.food)) food.start(game.food, obstacles);
+    if (!samePoint(bonus.source, wantedBonus)) bonus.start(wantedBonus, obstacles);
+
+    const int taken = food.advance(cells_per_update, obstacles);
+    bonus.advance(cells_per_update - taken, obstacles);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "game.h"
+
+// Moves from every cell to the nearest food or bonus food, going around obstacles and
+// wrapping at the board edges. The snake's body isn't in it, so it changes only when
+// food does and one field serves many ticks. Each food has a field of its own, so food
+// that appears, moves or is eaten only redoes its own and a bonus that runs out costs
+// nothing. Redoing one is a breadth-first search from the food that update() takes a
+// slice of cells further each call, so a meal costs no single tick the whole board.
+// Until a search is done the cells it hasn't reached get a lower bound instead: more
+// than the distance it has got to, and no less than the straight wrapped distance.
+class DistanceField {
+public:
+    static constexpr uint16_t unreachable = 0xFFFF;
+
+    // Brings the field up to date with the game's food, or a slice closer to it; no
+    // work once it has caught up
+    void update(const GameState& game);
+
+    // Never more than the moves from a cell to the nearest food, and exact once
+    // complete(). unreachable only when no food can be reached from the cell.
+    uint16_t estimate(int cell) const {
+        const uint16_t toFood = food.estimate(cell, width);
+        const uint16_t toBonus = bonus.estimate(cell, width);
+        return toFood < toBonus ? toFood : toBonus;
+    }
+    bool complete() const { return food.done() && bonus.done(); }
+
+private:
+    // One food's field and the search filling it
+    struct Spread {
+        SDL_Point source = {-1, -1}; // x is -1 without food
+        std::vector<uint16_t> cells;
+        std::vector<int> queue;
+        size_t next = 0; // Cells before this in queue have had their neighbours reached
+
+        bool done() const { return next == queue.size(); }
+        void start(SDL_Point food, const Uint8* obstacles);
+        int advance(int limit, const Uint8* obstacles);
+        uint16_t estimate(int cell, int width) const;
+    };
+
+    Spread food;
+    Spread bonus;
+    const Uint8* board = nullptr; // Obstacle mask the fields were filled for
+    int width = 0;
+};
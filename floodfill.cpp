@@ -0,0 +1,90 @@
+#include "floodfill.h"
+#include "config.h"
+using namespace std;
+
+bool FloodFill::measure(const GameState& game, Reach reach[4]) {
+    for (int m = 0; m < 4; ++m) reach[m] = Reach();
+    const Config& board = config();
+    const int width = board.gridWidth;
+    const int height = board.gridHeight;
+    if (width > 64) return false;
+
+    const int last = width - 1;
+    if ((int)boardRows.size() != height) {
+        const uint64_t full = width == 64 ? ~0ull : (1ull << width) - 1;
+        boardRows.assign(height, full);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (board.blocked(x, y)) boardRows[y] &= ~(1ull << x);
+            }
+        }
+        open.resize(height);
+        region.resize(height);
+    }
+
+    // Every segment but the tail stays put; the tail's cell frees up unless the move eats
+    const SnakeBody& snake = game.snake;
+    const int length = (int)snake.size();
+    freeRows = boardRows;
+    for (int i = 0; i + 1 < length; ++i) freeRows[snake[i].y] &= ~(1ull << snake[i].x);
+    for (int y = 0; y < height; ++y) {
+        const uint64_t row = freeRows[y];
+        open[y] = Lanes{row, row, row, row};
+        region[y] = Lanes{0, 0, 0, 0};
+    }
+
+    const SnakeSegment head = snake.front();
+    const SnakeSegment oldTail = snake.back();
+    const SDL_Keycode reverse = oppositeDirection(game.direction);
+    SnakeSegment tails[4] = {};
+    bool live[4] = {};
+    for (int m = 0; m < 4; ++m) {
+        if (move_directions[m] == reverse) continue;
+        const SnakeSegment next = step(head, move_directions[m]);
+        if (checkCollision(game, next.x, next.y)) continue;
+        live[m] = true;
+        const bool eats = (next.x == game.food.x && next.y == game.food.y) ||
+                          (game.bonusFoodActive && next.x == game.bonusFood.x && next.y == game.bonusFood.y);
+        if (eats) {
+            open[oldTail.y][m] &= ~(1ull << oldTail.x);
+            tails[m] = oldTail;
+        } else {
+            tails[m] = length > 1 ? snake[length - 2] : next;
+        }
+        region[next.y][m] |= 1ull << next.x;
+    }
+
+    // Grow each row from its neighbours, then run it along its own free cells; sweeping
+    // down and then up carries the fill the length of the board in one round
+    auto any = [](const Lanes& lanes) { return (lanes[0] | lanes[1] | lanes[2] | lanes[3]) != 0; };
+    auto grow = [&](int y, Lanes& changed) {
+        const Lanes before = region[y];
+        Lanes row = (before | region[y ? y - 1 : height - 1] | region[y + 1 < height ? y + 1 : 0]) & open[y];
+        Lanes spread;
+        do {
+            spread = row;
+            row |= ((row << 1) | (row >> last) | (row >> 1) | (row << last)) & open[y];
+        } while (any(row ^ spread));
+        region[y] = row;
+        changed |= row ^ before;
+    };
+    Lanes changed;
+    do {
+        changed = Lanes{0, 0, 0, 0};
+        for (int y = 0; y < height; ++y) grow(y, changed);
+        for (int y = height - 1; y >= 0; --y) grow(y, changed);
+    } while (any(changed));
+
+    for (int m = 0; m < 4; ++m) {
+        if (!live[m]) continue;
+        for (int y = 0; y < height; ++y) reach[m].cells += __builtin_popcountll(region[y][m]);
+        const SnakeSegment tail = tails[m];
+        bool touches = region[tail.y][m] >> tail.x & 1;
+        for (SDL_Keycode direction : move_directions) {
+            const SnakeSegment cell = step(tail, direction);
+            touches |= region[cell.y][m] >> cell.x & 1;
+        }
+        reach[m].tail = touches;
+    }
+    return true;
+}
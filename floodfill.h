@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "game.h"
+
+// What a move leaves the snake: the free cells it can still reach from its new head,
+// and whether one of them borders its new tail, in which case it can always follow the
+// tail out however small the region is
+struct Reach {
+    int cells = 0;
+    bool tail = false;
+};
+
+// Reachable area after each move, found by flood filling bitboards. Each board row is
+// one 64-bit word; a fill step ORs every row with itself shifted a cell left and right
+// (wrapping at the board edge) and with the rows above and below (wrapping at the top
+// and bottom), then masks out what isn't free. The four moves fill side by side in the
+// lanes of a GCC vector, so one pass over the rows serves every move. Buffers are kept
+// between calls, so use one per thread.
+class FloodFill {
+public:
+    // Fills reach in UP, DOWN, LEFT, RIGHT order. A move that reverses or collides
+    // reaches nothing. Returns false, reaching nothing, on boards wider than 64 cells.
+    bool measure(const GameState& game, Reach reach[4]);
+
+private:
+    typedef uint64_t Lanes __attribute__((vector_size(32)));
+
+    std::vector<uint64_t> boardRows; // Cells without obstacles
+    std::vector<uint64_t> freeRows;  // Cells the snake won't cover after a move that doesn't eat
+    std::vector<Lanes> open;         // Cells each move's fill may enter
+    std::vector<Lanes> region;       // Cells each move's fill has reached
+};
@@ -0,0 +1,275 @@
+#include "game.h"
+#include <algorithm>
+#include <cstdlib>
+#include "audio.h"
+#include "config.h"
+using namespace std;
+
+namespace {
+
+int cellIndex(int x, int y) {
+    return y * config().gridWidth + x;
+}
+
+// Random keys for each feature of a position: one per cell for the body, the head, the
+// tail, the food and the bonus food, and one per direction
+struct ZobristKeys {
+    vector<uint64_t> body, head, tail, food, bonus;
+    uint64_t direction[4];
+};
+
+const ZobristKeys& zobrist() {
+    static const ZobristKeys keys = [] {
+        // splitmix64, from a fixed seed so hashes are the same on every run
+        uint64_t state = 0x5EED5EED5EED5EEDull;
+        auto next = [&state] {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        ZobristKeys result;
+        const int cells = config().gridWidth * config().gridHeight;
+        for (vector<uint64_t>* table : {&result.body, &result.head, &result.tail, &result.food, &result.bonus}) {
+            table->resize(cells);
+            for (uint64_t& key : *table) key = next();
+        }
+        for (uint64_t& key : result.direction) key = next();
+        return result;
+    }();
+    return keys;
+}
+
+uint64_t pointKey(const vector<uint64_t>& keys, SDL_Point point) {
+    return point.x < 0 ? 0 : keys[cellIndex(point.x, point.y)];
+}
+
+void placeFood(GameState& game, SDL_Point food) {
+    const vector<uint64_t>& keys = zobrist().food;
+    game.hash ^= pointKey(keys, game.food) ^ pointKey(keys, food);
+    game.food = food;
+}
+
+void occupy(GameState& game, int cell) {
+    int slot = game.freeSlot[cell];
+    int last = game.freeCells.back();
+    game.freeCells[slot] = last;
+    game.freeSlot[last] = slot;
+    game.freeCells.pop_back();
+    game.freeSlot[cell] = -1;
+}
+
+void release(GameState& game, int cell) {
+    game.freeSlot[cell] = (int)game.freeCells.size();
+    game.freeCells.push_back(cell);
+}
+
+// A free cell other than avoid, or -1 if there isn't one
+int randomFreeCell(GameState& game, SDL_Point avoid) {
+    const int avoidCell = avoid.x < 0 ? -1 : cellIndex(avoid.x, avoid.y);
+    const size_t available = game.freeCells.size() - (avoidCell >= 0 && game.freeSlot[avoidCell] >= 0 ? 1 : 0);
+    if (available == 0) return -1;
+    int cell;
+    do {
+        cell = game.freeCells[nextRandom(game) % game.freeCells.size()];
+    } while (cell == avoidCell);
+    return cell;
+}
+
+} // namespace
+
+void SnakeBody::reset(size_t capacity, SnakeSegment head) {
+    cells.resize(capacity);
+    first = 0;
+    count = 1;
+    cells[0] = head;
+}
+
+void SnakeBody::push_front(SnakeSegment segment) {
+    first = first ? first - 1 : cells.size() - 1;
+    cells[first] = segment;
+    ++count;
+}
+
+void resetGame(GameState& game, uint64_t seed) {
+    const Config& board = config();
+    const int cells = board.gridWidth * board.gridHeight;
+    game.snake.reset(cells, {min(15, board.gridWidth - 1), min(15, board.gridHeight - 1)});
+    game.food = {min(10, board.gridWidth - 1), min(10, board.gridHeight - 1)};
+    game.bonusFood = {-1, -1};
+    game.direction = SDLK_RIGHT;
+    game.bonusFoodActive = false;
+    game.score = 0;
+    game.alive = true;
+    game.won = false;
+    game.muted = false;
+    game.ticks = 0;
+    game.rng = seed ? seed : 0x9E3779B97F4A7C15ull;
+    game.prevHead = game.prevTail = game.snake.front();
+    game.hash = computeHash(game);
+
+    game.freeCells.clear();
+    game.freeSlot.assign(cells, -1);
+    for (int cell = 0; cell < cells; ++cell) {
+        if (!board.obstacleMask[cell]) release(game, cell);
+    }
+    occupy(game, cellIndex(game.snake.front().x, game.snake.front().y));
+}
+
+void update(GameState& game) {
+    SnakeBody& snake = game.snake;
+    game.prevHead = snake.front();
+    game.prevTail = snake.back();
+    game.ticks++;
+
+    SnakeSegment next = step(snake.front(), game.direction);
+    int headX = next.x;
+    int headY = next.y;
+
+    if (checkCollision(game, headX, headY)) {
+        if (!game.muted) postSound(SoundEvent::Death);
+        game.alive = false;
+        return;
+    }
+
+    const ZobristKeys& keys = zobrist();
+    const int oldHead = cellIndex(game.prevHead.x, game.prevHead.y);
+    const int head = cellIndex(headX, headY);
+    SnakeSegment newHead = {headX, headY};
+    snake.push_front(newHead);
+    occupy(game, head);
+    game.hash ^= keys.body[head] ^ keys.head[oldHead] ^ keys.head[head];
+    if (headX == game.food.x && headY == game.food.y) {
+        if (!game.muted) postSound(SoundEvent::Eat);
+        game.score++;
+        // With only the bonus food's cell left there is nowhere for food to go; eating
+        // the bonus fills the board
+        if (!spawnFood(game)) placeFood(game, {-1, -1});
+
+        if (game.score % 5 == 0 && !game.bonusFoodActive) spawnBonusFood(game);
+    } else if (game.bonusFoodActive && headX == game.bonusFood.x && headY == game.bonusFood.y) {
+        if (!game.muted) postSound(SoundEvent::Bonus);
+        game.score += 10;
+        game.bonusFoodActive = false;
+        game.bonusFood = {-1, -1};
+        game.hash ^= keys.bonus[head];
+    } else {
+        const int tail = cellIndex(snake.back().x, snake.back().y);
+        snake.pop_back();
+        release(game, tail);
+        game.hash ^= keys.body[tail] ^ keys.tail[tail] ^ keys.tail[cellIndex(snake.back().x, snake.back().y)];
+    }
+
+    if (game.freeCells.empty()) {
+        game.won = true;
+        game.alive = false;
+    }
+}
+
+bool checkCollision(const GameState& game, int x, int y) {
+    return game.freeSlot[cellIndex(x, y)] < 0;
+}
+
+// Food can't land on the snake, the bonus food or an obstacle, where it could never be eaten
+bool spawnFood(GameState& game) {
+    int cell = randomFreeCell(game, game.bonusFoodActive ? game.bonusFood : SDL_Point{-1, -1});
+    if (cell < 0) return false;
+    placeFood(game, {cell % config().gridWidth, cell / config().gridWidth});
+    return true;
+}
+
+bool spawnBonusFood(GameState& game) {
+    int cell = randomFreeCell(game, game.food);
+    if (cell < 0) return false;
+    game.bonusFood = {cell % config().gridWidth, cell / config().gridWidth};
+    game.bonusFoodActive = true;
+    game.hash ^= zobrist().bonus[cell];
+    return true;
+}
+
+int moveIndex(SDL_Keycode direction) {
+    switch (direction) {
+        case SDLK_UP: return 0;
+        case SDLK_DOWN: return 1;
+        case SDLK_LEFT: return 2;
+        default: return 3;
+    }
+}
+
+uint32_t nextRandom(GameState& game) {
+    return xorshift32(game.rng);
+}
+
+SnakeSegment step(SnakeSegment cell, SDL_Keycode direction) {
+    const Config& board = config();
+    switch (direction) {
+        case SDLK_UP: cell.y--; break;
+        case SDLK_DOWN: cell.y++; break;
+        case SDLK_LEFT: cell.x--; break;
+        case SDLK_RIGHT: cell.x++; break;
+    }
+
+    // Wrap around the screen
+    if (cell.x < 0) cell.x = board.gridWidth - 1;
+    if (cell.x >= board.gridWidth) cell.x = 0;
+    if (cell.y < 0) cell.y = board.gridHeight - 1;
+    if (cell.y >= board.gridHeight) cell.y = 0;
+    return cell;
+}
+
+SDL_Keycode oppositeDirection(SDL_Keycode direction) {
+    switch (direction) {
+        case SDLK_UP: return SDLK_DOWN;
+        case SDLK_DOWN: return SDLK_UP;
+        case SDLK_LEFT: return SDLK_RIGHT;
+        default: return SDLK_LEFT;
+    }
+}
+
+int wrappedDistance(SnakeSegment a, SDL_Point b) {
+    const Config& board = config();
+    return abs(wrappedDelta(a.x, b.x, board.gridWidth)) + abs(wrappedDelta(a.y, b.y, board.gridHeight));
+}
+
+SnakeSegment wrapCell(int x, int y) {
+    const Config& board = config();
+    x %= board.gridWidth;
+    y %= board.gridHeight;
+    return {x < 0 ? x + board.gridWidth : x, y < 0 ? y + board.gridHeight : y};
+}
+
+const vector<int>& neighbourCells() {
+    static const vector<int> table = [] {
+        const Config& board = config();
+        vector<int> neighbours(board.gridWidth * board.gridHeight * 4);
+        for (int y = 0; y < board.gridHeight; ++y) {
+            for (int x = 0; x < board.gridWidth; ++x) {
+                for (int m = 0; m < 4; ++m) {
+                    const SnakeSegment next = step({x, y}, move_directions[m]);
+                    neighbours[(y * board.gridWidth + x) * 4 + m] = next.y * board.gridWidth + next.x;
+                }
+            }
+        }
+        return neighbours;
+    }();
+    return table;
+}
+
+bool turn(GameState& game, SDL_Keycode direction) {
+    if (direction == oppositeDirection(game.direction)) return false;
+    const ZobristKeys& keys = zobrist();
+    game.hash ^= keys.direction[moveIndex(game.direction)] ^ keys.direction[moveIndex(direction)];
+    game.direction = direction;
+    return true;
+}
+
+uint64_t computeHash(const GameState& game) {
+    const ZobristKeys& keys = zobrist();
+    uint64_t hash = keys.direction[moveIndex(game.direction)];
+    for (const SnakeSegment& segment : game.snake) hash ^= keys.body[cellIndex(segment.x, segment.y)];
+    hash ^= keys.head[cellIndex(game.snake.front().x, game.snake.front().y)];
+    hash ^= keys.tail[cellIndex(game.snake.back().x, game.snake.back().y)];
+    hash ^= pointKey(keys.food, game.food);
+    if (game.bonusFoodActive) hash ^= pointKey(keys.bonus, game.bonusFood);
+    return hash;
+}
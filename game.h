@@ -0,0 +1,139 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+
+struct SnakeSegment {
+    int x, y;
+};
+
+// The snake, head first, in a ring buffer sized to the board when the game starts.
+// Moving and growing never shift the body, so a tick costs the same at any length.
+class SnakeBody {
+public:
+    class Iterator {
+    public:
+        Iterator(const SnakeBody* body, size_t index) : body(body), index(index) {}
+        const SnakeSegment& operator*() const { return (*body)[index]; }
+        Iterator& operator++() { ++index; return *this; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+
+    private:
+        const SnakeBody* body;
+        size_t index;
+    };
+
+    void reset(size_t capacity, SnakeSegment head);
+    void push_front(SnakeSegment segment);
+    void pop_back() { --count; }
+
+    size_t size() const { return count; }
+    const SnakeSegment& front() const { return cells[first]; }
+    const SnakeSegment& back() const { return (*this)[count - 1]; }
+    const SnakeSegment& operator[](size_t i) const {
+        size_t slot = first + i;
+        return cells[slot < cells.size() ? slot : slot - cells.size()];
+    }
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, count); }
+
+private:
+    std::vector<SnakeSegment> cells;
+    size_t first = 0;
+    size_t count = 0;
+};
+
+// Everything one game needs. The simulation thread owns the live copy; the renderer
+// only ever sees snapshots of it. The board comes from config().
+struct GameState {
+    SnakeBody snake;
+    SDL_Point food;
+    SDL_Point bonusFood;
+    SDL_Keycode direction;
+    bool bonusFoodActive;
+    int score;
+    bool alive;
+    bool won; // The snake filled the board; alive is false too, as the game is over
+    bool muted; // No sounds, for the copies bots play out while searching
+    uint64_t ticks;
+
+    // Each game draws food positions from its own generator, so a seed replays a game
+    // exactly and games on different threads don't share anything
+    uint64_t rng;
+
+    // Every cell that is neither snake nor obstacle, and each cell's index in that list
+    // (-1 when it isn't free). Food spawns in O(1) and a collision is one lookup, even
+    // with the board all but full.
+    std::vector<int> freeCells;
+    std::vector<int> freeSlot;
+
+    // Zobrist hash of the position: body cells, head, tail, direction, food and bonus
+    // food. The snake's path between head and tail isn't in it, nor is the generator,
+    // so it names what a player can see. update(), turn() and the spawns keep it
+    // current as they go.
+    uint64_t hash;
+
+    // Where the head and tail were before the last tick, for interpolation
+    SnakeSegment prevHead;
+    SnakeSegment prevTail;
+};
+
+// The four headings in the order the bots number their moves, and the step each one takes
+const SDL_Keycode move_directions[4] = {SDLK_UP, SDLK_DOWN, SDLK_LEFT, SDLK_RIGHT};
+const int move_dx[4] = {0, 0, -1, 1};
+const int move_dy[4] = {-1, 1, 0, 0};
+int moveIndex(SDL_Keycode direction); // Where the direction is in move_directions
+
+// xorshift64*: a few cycles per number, and the one generator everything here uses.
+// The state must not be zero. The high bits of the result are the best mixed, so
+// xorshift32() keeps those.
+inline uint64_t xorshift64(uint64_t& state) {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545F4914F6CDD1Dull;
+}
+inline uint32_t xorshift32(uint64_t& state) {
+    return (uint32_t)(xorshift64(state) >> 32);
+}
+
+void resetGame(GameState& game, uint64_t seed);
+void update(GameState& game);
+uint32_t nextRandom(GameState& game); // From the game's own generator, for placing food
+
+// The cell one step from cell in direction, wrapping around the board
+SnakeSegment step(SnakeSegment cell, SDL_Keycode direction);
+SDL_Keycode oppositeDirection(SDL_Keycode direction);
+
+// Shortest distance between two cells when every edge wraps
+int wrappedDistance(SnakeSegment a, SDL_Point b);
+
+// Signed offset from one coordinate to another the short way round an axis of size
+// cells. Takes the fractional positions the renderer interpolates as well as cells.
+template <typename T>
+T wrappedDelta(T from, T to, int size) {
+    T delta = to - from;
+    if (delta > size / T(2)) delta -= size;
+    else if (delta < -size / T(2)) delta += size;
+    return delta;
+}
+
+// The cell at x, y with both coordinates wrapped onto the board, however far off it
+SnakeSegment wrapCell(int x, int y);
+
+// For every cell of the board (y * width + x), the four cells one move away in
+// move_directions order, wrapped. Built on first use, so searches step between cells
+// without dividing by the width.
+const std::vector<int>& neighbourCells();
+
+// Takes the new heading unless it would reverse the snake into itself
+bool turn(GameState& game, SDL_Keycode direction);
+// True if the cell holds the snake (tail included) or an obstacle
+bool checkCollision(const GameState& game, int x, int y);
+
+// False when there is no free cell left to put it on
+bool spawnFood(GameState& game);
+bool spawnBonusFood(GameState& game); // Also makes it active
+
+// The hash worked out from scratch, to check the one update() keeps
+uint64_t computeHash(const GameState& game);
@@ -0,0 +1,160 @@
+#include "hamiltonian.h"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "config.h"
+using namespace std;
+
+namespace {
+
+// Steps of the cycle search before it gives up on a board; the default board needs
+// about ten thousand
+const long max_search_steps = 20000000;
+
+struct Cycle {
+    vector<int> cells; // Free cells in cycle order
+    vector<int> order; // Each cell's index in cells, -1 for obstacles
+};
+
+// Posa's rotation-extension. Grow a path from one cell, stepping to the unvisited
+// neighbour with the fewest unvisited neighbours of its own. When the end is stuck,
+// take a neighbour u of the end that is already on the path and reverse the stretch
+// after u: the path keeps every cell but ends somewhere new. Once it covers the board,
+// keep rotating until the end sits next to the start and the path closes.
+Cycle findCycle() {
+    const Config& board = config();
+    const int width = board.gridWidth;
+    const int height = board.gridHeight;
+    const int cells = width * height;
+    const vector<int>& neighbours = neighbourCells();
+
+    vector<int> degree(cells, 0);
+    vector<int> adjacent(cells * 4);
+    int freeCount = 0;
+    for (int cell = 0; cell < cells; ++cell) {
+        if (board.obstacleMask[cell]) continue;
+        ++freeCount;
+        for (int m = 0; m < 4; ++m) {
+            int next = neighbours[cell * 4 + m];
+            if (!board.obstacleMask[next] && next != cell) adjacent[cell * 4 + degree[cell]++] = next;
+        }
+    }
+
+    Cycle cycle;
+    cycle.order.assign(cells, -1);
+    if (freeCount < 4) return cycle;
+
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+    auto random = [&rng] { return xorshift32(rng); };
+
+    vector<int>& path = cycle.cells;
+    vector<int>& position = cycle.order;
+    int start = 0;
+    while (board.obstacleMask[start]) ++start;
+    path.push_back(start);
+    position[start] = 0;
+
+    for (long steps = 0; steps < max_search_steps; ++steps) {
+        const int end = path.back();
+        if ((int)path.size() == freeCount) {
+            for (int k = 0; k < degree[end]; ++k) {
+                if (adjacent[end * 4 + k] == path[0]) return cycle;
+            }
+        }
+
+        int best = -1;
+        int bestOnward = 5;
+        for (int k = 0; k < degree[end]; ++k) {
+            int next = adjacent[end * 4 + k];
+            if (position[next] >= 0) continue;
+            int onward = 0;
+            for (int j = 0; j < degree[next]; ++j) onward += position[adjacent[next * 4 + j]] < 0;
+            if (onward < bestOnward || (onward == bestOnward && random() % 2)) {
+                best = next;
+                bestOnward = onward;
+            }
+        }
+        if (best >= 0) {
+            position[best] = (int)path.size();
+            path.push_back(best);
+            continue;
+        }
+
+        if (degree[end] == 0) break;
+        int pivot = position[adjacent[end * 4 + random() % degree[end]]];
+        if (pivot >= (int)path.size() - 2) continue;
+        reverse(path.begin() + pivot + 1, path.end());
+        for (int i = pivot + 1; i < (int)path.size(); ++i) position[path[i]] = i;
+    }
+
+    cerr << "No Hamiltonian cycle found for this board" << endl;
+    cycle.cells.clear();
+    cycle.order.assign(cells, -1);
+    return cycle;
+}
+
+// The board never changes during a run, so every solver on every thread shares one cycle
+const Cycle& boardCycle() {
+    static const Cycle cycle = findCycle();
+    return cycle;
+}
+
+} // namespace
+
+int HamiltonianSolver::cycleLength() {
+    return (int)boardCycle().cells.size();
+}
+
+SDL_Keycode HamiltonianSolver::plan(const GameState& game) {
+    const Cycle& cycle = boardCycle();
+    const int n = (int)cycle.cells.size();
+    if (n == 0) return 0;
+    const int width = config().gridWidth;
+    const vector<int>& neighbours = neighbourCells();
+
+    // Steps from one cell to another going forward around the cycle
+    auto ahead = [&](int from, int to) {
+        int steps = cycle.order[to] - cycle.order[from];
+        return steps < 0 ? steps + n : steps;
+    };
+
+    const int length = (int)game.snake.size();
+    const int head = game.snake.front().y * width + game.snake.front().x;
+    const int toTail = length > 1 ? ahead(head, game.snake.back().y * width + game.snake.back().x) : n;
+    int toFood = n;
+    if (game.food.x >= 0) toFood = ahead(head, game.food.y * width + game.food.x);
+    if (game.bonusFoodActive) toFood = min(toFood, ahead(head, game.bonusFood.y * width + game.bonusFood.x));
+
+    // The body lies between the tail and the head in cycle order, and every cell
+    // strictly between the head and the tail going forward is free. Landing on one of
+    // those keeps that order, so following the cycle from there never runs into the
+    // body; it only fails if meals use up the free cells ahead of the head while cells
+    // it skipped are still waiting behind the tail. So a shortcut leaves at least as
+    // many free cells ahead as there are anywhere else, plus one for each food on the
+    // board, and stops at the food so nothing is skipped past it.
+    int reach = 1;
+    const int freeCells = n - length;
+    if (freeCells >= n / 2) {
+        const int foods = (game.food.x >= 0) + game.bonusFoodActive;
+        const int room = toTail - 1 - (freeCells + foods + 1) / 2;
+        reach = max(1, min(room, toFood));
+    }
+
+    const SDL_Keycode reverse = oppositeDirection(game.direction);
+    int best = -1;
+    int bestAhead = 0;
+    int follow = 0;
+    for (int m = 0; m < 4; ++m) {
+        const int next = neighbours[head * 4 + m];
+        if (cycle.order[next] < 0) continue;
+        const int steps = ahead(head, next);
+        if (steps == 1) follow = m;
+        if (move_directions[m] == reverse || checkCollision(game, next % width, next / width)) continue;
+        if (steps <= reach && steps > bestAhead) {
+            best = m;
+            bestAhead = steps;
+        }
+    }
+    return move_directions[best >= 0 ? best : follow];
+}
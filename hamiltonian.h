@@ -0,0 +1,20 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include "game.h"
+
+// Plays a perfect game by following a Hamiltonian cycle: a closed route through every
+// free cell of the board. The cycle is found once per board and shared by every
+// solver. A snake that keeps its body in cycle order, head leading and tail behind,
+// can never run into itself, so the solver only leaves the cycle for shortcuts that
+// keep that order: a jump ahead along the cycle to a cell strictly between the head
+// and the tail, no further than the food, that leaves at least half the free cells
+// ahead of the head for the growth eating will bring. Shortcuts stop once the snake
+// covers half the board, and from there it simply follows the cycle to the end.
+class HamiltonianSolver {
+public:
+    // Next move, or 0 if the board has no Hamiltonian cycle the search could find
+    SDL_Keycode plan(const GameState& game);
+
+    // Length of the cycle (the number of free cells), or 0 without one
+    static int cycleLength();
+};
@@ -0,0 +1,248 @@
+#include "headless.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bot.h"
+#include "config.h"
+#include "game.h"
+#include "metrics.h"
+#include "threadpool.h"
+using namespace std;
+
+namespace {
+
+// Most CPU time --fill-check allows a game, startup and cycle search included
+const double fill_check_cpu_ms = 250.0;
+
+struct ScriptedTurn {
+    uint64_t tick;
+    SDL_Keycode direction;
+};
+
+struct GameResult {
+    uint64_t seed = 0;
+    int score = 0;
+    size_t length = 0;
+    uint64_t ticks = 0;
+    bool died = false;
+    bool won = false;
+};
+
+atomic<Uint64> firstTickCounter{0};
+atomic<uint64_t> hashesChecked{0};
+atomic<uint64_t> hashMismatches{0};
+
+// With --hash-check, compares the hash the engine keeps against one worked out from scratch
+void checkHash(const GameState& game) {
+    if (!config().hashCheck) return;
+    hashesChecked.fetch_add(1, memory_order_relaxed);
+    if (game.hash != computeHash(game) && hashMismatches.fetch_add(1, memory_order_relaxed) == 0) {
+        cerr << "Hash mismatch at tick " << game.ticks << ": " << hex << game.hash << " kept, " << computeHash(game)
+             << " computed" << dec << endl;
+    }
+}
+
+double millisecondsBetween(Uint64 from, Uint64 to) {
+    return (to - from) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+bool parseDirection(const string& name, SDL_Keycode& direction) {
+    if (name == "up") direction = SDLK_UP;
+    else if (name == "down") direction = SDLK_DOWN;
+    else if (name == "left") direction = SDLK_LEFT;
+    else if (name == "right") direction = SDLK_RIGHT;
+    else return false;
+    return true;
+}
+
+bool loadScript(const string& path, vector<ScriptedTurn>& turns) {
+    ifstream file(path);
+    if (!file) {
+        cerr << "Failed to open script " << path << endl;
+        return false;
+    }
+    string line;
+    for (int number = 1; getline(file, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == string::npos) continue;
+        ScriptedTurn turn;
+        string name;
+        if (!(istringstream(line) >> turn.tick >> name) || !parseDirection(name, turn.direction)) {
+            cerr << path << ":" << number << ": bad turn: " << line << endl;
+            return false;
+        }
+        turns.push_back(turn);
+    }
+    stable_sort(turns.begin(), turns.end(), [](const ScriptedTurn& a, const ScriptedTurn& b) { return a.tick < b.tick; });
+    return true;
+}
+
+GameResult resultOf(const GameState& game, uint64_t seed) {
+    GameResult result;
+    result.seed = seed;
+    result.score = game.score;
+    result.length = game.snake.size();
+    result.ticks = game.ticks;
+    result.died = !game.alive && !game.won;
+    result.won = game.won;
+    return result;
+}
+
+GameResult playGame(Autopilot& autopilot, uint64_t seed, const vector<ScriptedTurn>* script) {
+    GameState game;
+    resetGame(game, seed);
+    size_t nextTurn = 0;
+    const uint64_t maxTicks = config().maxTicks;
+    autopilot.reset();
+
+    while (game.alive && game.ticks < maxTicks) {
+        if (script) {
+            for (; nextTurn < script->size() && (*script)[nextTurn].tick <= game.ticks; ++nextTurn) {
+                turn(game, (*script)[nextTurn].direction);
+            }
+        } else {
+            turn(game, autopilot.move(game));
+        }
+        checkHash(game);
+        update(game);
+        checkHash(game);
+
+        if (game.ticks == 1) {
+            Uint64 expected = 0;
+            firstTickCounter.compare_exchange_strong(expected, SDL_GetPerformanceCounter());
+        }
+    }
+
+    return resultOf(game, seed);
+}
+
+// Plays games side by side, a tick of each at a time, so the neural bot can run all
+// their positions through its network as one batch. Finished games drop out.
+void playBatch(uint64_t firstSeed, GameResult* results, int count) {
+    vector<GameState> games(count);
+    for (int i = 0; i < count; ++i) resetGame(games[i], firstSeed + i);
+    const uint64_t maxTicks = config().maxTicks;
+    Autopilot autopilot(config().bot);
+    vector<const GameState*> playing(count);
+    vector<int> index(count);
+    vector<SDL_Keycode> directions(count);
+
+    while (true) {
+        int active = 0;
+        for (int i = 0; i < count; ++i) {
+            if (!games[i].alive || games[i].ticks >= maxTicks) continue;
+            playing[active] = &games[i];
+            index[active++] = i;
+        }
+        if (active == 0) break;
+        autopilot.moves(playing.data(), active, directions.data());
+        for (int a = 0; a < active; ++a) {
+            GameState& game = games[index[a]];
+            turn(game, directions[a]);
+            checkHash(game);
+            update(game);
+            checkHash(game);
+        }
+        Uint64 expected = 0;
+        firstTickCounter.compare_exchange_strong(expected, SDL_GetPerformanceCounter());
+    }
+    for (int i = 0; i < count; ++i) results[i] = resultOf(games[i], firstSeed + i);
+}
+
+} // namespace
+
+int runHeadless(Uint64 startCounter) {
+    const Config& settings = config();
+
+    vector<ScriptedTurn> script;
+    if (!settings.script.empty() && !loadScript(settings.script, script)) return 1;
+    const vector<ScriptedTurn>* input = settings.script.empty() ? nullptr : &script;
+
+    const uint64_t baseSeed = settings.seed ? settings.seed : SDL_GetPerformanceCounter();
+    vector<GameResult> results(settings.games);
+
+    Uint64 runStart = SDL_GetPerformanceCounter();
+    {
+        ThreadPool pool(min<unsigned>(settings.games, max(1u, thread::hardware_concurrency())));
+        const unsigned searchThreads = pool.size() > 1 ? 1 : 0;
+        if (!input && settings.bot == Bot::Neural) {
+            // One batch of games per thread
+            const int perThread = (settings.games + pool.size() - 1) / pool.size();
+            for (int first = 0; first < settings.games; first += perThread) {
+                const int count = min(perThread, settings.games - first);
+                pool.submit([&results, first, count, baseSeed] { playBatch(baseSeed + first, &results[first], count); });
+            }
+        } else {
+            // Each worker takes the next game until none are left, with one autopilot
+            // for all of them. Searches get one thread each when the pool already has
+            // every core busy.
+            atomic<int> nextGame{0};
+            for (unsigned t = 0; t < pool.size(); ++t) {
+                pool.submit([&results, &nextGame, &settings, baseSeed, input, searchThreads] {
+                    Autopilot autopilot(settings.bot, searchThreads);
+                    for (int i; (i = nextGame.fetch_add(1)) < settings.games;) {
+                        results[i] = playGame(autopilot, baseSeed + i, input);
+                    }
+                });
+            }
+        }
+        pool.wait();
+    }
+    Uint64 runEnd = SDL_GetPerformanceCounter();
+
+    uint64_t totalTicks = 0;
+    long long totalScore = 0;
+    int best = 0;
+    int wins = 0;
+    for (int i = 0; i < settings.games; ++i) {
+        const GameResult& r = results[i];
+        cout << "game " << i + 1 << " seed " << r.seed << ": score " << r.score << ", length " << r.length << ", "
+             << r.ticks << " ticks, " << (r.won ? "won" : r.died ? "died" : "timed out") << endl;
+        totalTicks += r.ticks;
+        totalScore += r.score;
+        best = max(best, r.score);
+        wins += r.won;
+    }
+
+    double runMs = millisecondsBetween(runStart, runEnd);
+    cout << fixed << setprecision(2);
+    cout << "Headless: " << settings.games << " games (" << (input ? "script" : botName(settings.bot)) << "), mean score "
+         << double(totalScore) / settings.games << ", best " << best << ", " << wins << " won" << endl;
+    cout << "  " << totalTicks << " ticks in " << runMs << " ms (" << setprecision(0) << totalTicks / max(runMs, 1e-3) * 1000.0
+         << " ticks/s)" << setprecision(3) << ", first tick " << millisecondsBetween(startCounter, firstTickCounter.load())
+         << " ms after start, " << processCpuSeconds() * 1000.0 << " ms CPU" << endl;
+    if (!input) metrics.autopilotPlan.report(cout, "autopilot plan time");
+    if (metrics.pathPlans.load()) {
+        cout << "  " << metrics.pathPlans.load() << " path plans, " << metrics.pathFallbacks.load() << " left to greedy ("
+             << setprecision(1) << 100.0 * metrics.pathFallbacks.load() / metrics.pathPlans.load() << "%, "
+             << metrics.pathSearchesCapped.load() << " capped)" << endl;
+    }
+    if (metrics.searchRollouts.load()) {
+        cout << "  " << metrics.searchRollouts.load() << " search rollouts (" << setprecision(0)
+             << metrics.searchRollouts.load() / max(metrics.searchMicros.load() / 1e6, 1e-6) << "/s, " << metrics.searchTableHits.load() << " table hits)" << endl;
+    }
+    if (metrics.inferences.load()) {
+        cout << "  " << metrics.inferences.load() << " network inferences (" << setprecision(0)
+             << metrics.inferences.load() / max(metrics.inferenceMicros.load() / 1e6, 1e-6) << "/s)" << endl;
+    }
+    if (settings.hashCheck) {
+        cout << "Hash check: " << hashesChecked.load() << " positions, " << hashMismatches.load() << " mismatches "
+             << (hashMismatches.load() ? "FAILED" : "ok") << endl;
+        if (hashMismatches.load()) return 1;
+    }
+    if (settings.fillCheck) {
+        const double cpuMs = processCpuSeconds() * 1000.0 / settings.games;
+        const bool failed = wins < settings.games || cpuMs >= fill_check_cpu_ms;
+        const long cells = count(settings.obstacleMask.begin(), settings.obstacleMask.end(), 0);
+        cout << "Fill check: " << wins << " of " << settings.games << " boards of " << cells << " cells filled, " << setprecision(1) << cpuMs << " ms CPU per game (limit " << fill_check_cpu_ms << ") "
+             << (failed ? "FAILED" : "ok") << endl;
+        if (failed) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <SDL2/SDL.h>
+
+// Plays config().games games with no window, audio or fonts, as fast as the CPU allows,
+// spread over a thread pool. Input comes from config().script when set, otherwise from
+// config().bot, with one autopilot per thread; search bots plan on a single thread when
+// the pool has more than one. The neural bot plays each thread's games side by side in
+// one batch. A script is a text file of "tick direction" lines ("12 up"), applied
+// before that tick is run. Results go to stdout; returns the process exit code.
+// startCounter is the SDL performance counter when the process started.
+int runHeadless(Uint64 startCounter);
@@ -3,287 +3,820 @@
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_ttf.h>
 #include <SDL2/SDL_mixer.h>
+#include "assetpack.h"
+#include "audio.h"
+#include "bakedassets.h"
+#include "config.h"
+#include "headless.h"
+#include "metrics.h"
+#include "musicstream.h"
+#include "pacing.h"
+#include "policy.h"
+#include "simulation.h"
+#include "threadpool.h"
+#include "tournament.h"
+#include "trainer.h"
 using namespace std;
 
 // Constants
-const int screen_width = 700;
-const int screen_height = 500;
-const int block_size = 20;
-
-// Structures
-struct SnakeSegment {
-    int x, y;
-};
-
-// Obstacles
-SDL_Rect obstacle1{100, 120, 200, 20};
-SDL_Rect obstacle2{420, 360, 200, 20};
-SDL_Rect obstacle3{300, 240, 100, 20};
+const int idle_wait_ms = 250;
+const int idle_check_seconds = 5;
+const double idle_cpu_target = 1.0; // Percent of one core
 
 // SDL Variables
 SDL_Window* window = nullptr;
 SDL_Renderer* renderer = nullptr;
-TTF_Font* font = nullptr;
-SDL_Texture* scoreTexture = nullptr;
+FontAtlas fontAtlas;
 SDL_Texture* backgroundTexture = nullptr;
 
 // Audio
-Mix_Music* bgMusic = nullptr;
+Mix_Chunk* musicChunk = nullptr; // The track decoded at load time, when it isn't baked
 Mix_Chunk* eatSound = nullptr;
 Mix_Chunk* gameOverSound = nullptr;
 
+// Asset loading
+AssetPack assetPack;
+const int asset_count = 5;
+atomic<int> assetsLoaded{0};
+mutex assetErrorMutex;
+vector<string> assetErrors;
+
+// CPU-side results the loader hands to the render thread for upload. Baked assets are
+// used straight out of the pack; otherwise the workers decode the source files.
+struct BakedBlob {
+    const void* data = nullptr;
+    size_t size = 0;
+};
+BakedBlob bakedFont;
+BakedBlob bakedBackground;
+const Uint8* bakedMusic = nullptr;
+Uint32 bakedMusicBytes = 0;
+BakedFont fontAtlasHeader;
+SDL_Surface* fontAtlasSurface = nullptr;
+SDL_Surface* backgroundSurface = nullptr;
+
 // Score and State
-int score = 0;
-SDL_Rect scoreRect = {30, 30, 0, 0};
+int shownScore = -1;
+string scoreText;
+SDL_Point scorePosition = {30, 30};
 bool running = true;
 
+// Scenes. Only Playing runs every frame; the others sleep in the event queue and
+// redraw when something happens.
+enum class Scene {
+    Menu,
+    Playing,
+    Paused,
+    GameOver
+};
+Scene scene = Scene::Menu;
+
+// Window state. Nothing is drawn while the window is minimised or hidden, and while it
+// is in the background at all the game stays paused and music decoding is suspended.
+bool windowVisible = true;
+bool windowFocused = true;
+bool backgrounded = false;
+
+// Latency test. Synthetic turns go in through the event queue like real key presses and
+// are timed to the first present showing a snapshot that has applied them, once for
+// every pacing mode.
+const int latency_probes_per_mode = 30;
+const int latency_probe_interval_ms = 250;
+struct LatencyTest {
+    int mode = 0;
+    int probes = 0;
+    bool waiting = false;
+    Uint64 pushedAt = 0;
+    uint32_t baseline = 0;
+    Uint64 nextProbe = 0;
+    LatencyHistogram results[pacing_count];
+    Pacing effective[pacing_count];
+};
+LatencyTest latencyTest;
+
+// Smooth motion
+bool smoothMotion = true;
+vector<SDL_FPoint> snakeRun;
+vector<SDL_Vertex> snakeVertices;
+vector<int> snakeIndices;
+
 // Function prototypes
-void render(const vector<SnakeSegment>& snake, const SDL_Point& food, const SDL_Point& bonusFood);
-void update(vector<SnakeSegment>& snake, SDL_Point& food, SDL_Point& bonusFood, SDL_Keycode& direction, bool& bonusFoodActive);
-bool checkCollision(const vector<SnakeSegment>& snake, int x, int y);
-void spawnBonusFood(SDL_Point& bonusFood, const vector<SnakeSegment>& snake, const SDL_Point& food);
-void updateScoreTexture();
-void displayGameOver();
+SDL_RWops* openAsset(const char* name);
+BakedBlob findBaked(const string& name);
+Mix_Chunk* loadSound(const char* name);
+void loadAssets(ThreadPool& loader);
+bool uploadAssets();
+void benchmarkStartup();
+void renderLoadingScreen();
+double millisecondsSince(Uint64 counter);
+void render(const GameState& game, float alpha);
+void renderSmoothSnake(const GameState& game, float alpha);
+void updateScoreText(int score);
+void renderCentredText(const char* text, int y, SDL_Color color);
+void renderMenu();
+void renderPaused();
+void renderGameOver(bool won);
+void handleWindowEvent(const SDL_WindowEvent& event);
+void applyPacing(Pacing mode);
+void pushKey(SDL_Keycode key);
+void injectLatencyProbe(const GameSnapshot& snapshot);
+bool checkLatencyProbe(const GameSnapshot& snapshot);
 void cleanup();
 
 int main(int argc, char* argv[]) {
+    const Uint64 startCounter = SDL_GetPerformanceCounter();
+
+    if (!loadConfig(argc, argv)) return 1;
+    if (config().nnBench) return runNetworkBench();
+    if (config().train) return runTrainer();
+    if (config().tournament) return runTournament();
+    if (config().headless) return runHeadless(startCounter);
+    const bool useAudio = config().audio;
+
     // Initialize SDL, SDL_ttf, and SDL_mixer
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0 || TTF_Init() != 0 || Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+    if (SDL_Init(SDL_INIT_VIDEO | (useAudio ? SDL_INIT_AUDIO : 0)) != 0 || TTF_Init() != 0 || (useAudio && !openAudio(config().audioBuffer))) {
         cerr << "Initialization failed: " << SDL_GetError() << endl;
         return 1;
     }
 
     // Create window and renderer
-    window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, screen_width, screen_height, SDL_WINDOW_SHOWN);
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, config().screenWidth, config().screenHeight, SDL_WINDOW_SHOWN);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (config().pacing == Pacing::Vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+    if (!renderer) renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE); // e.g. the dummy video driver
+
+    // Decode assets on worker threads while the loading screen is up. Textures can only
+    // be created on this thread, so the background comes back as a surface. When the
+    // packed archive is present everything comes out of one mapping.
+    {
+        if (assetPack.open(config().assetPack.c_str())) cout << "Loading assets from " << config().assetPack << endl;
+
+        ThreadPool loader(asset_count);
+        loadAssets(loader);
+
+        bool firstFrame = true;
+        while (assetsLoaded.load() < asset_count) {
+            SDL_Event event;
+            while (SDL_PollEvent(&event)) {
+                if (event.type == SDL_QUIT) running = false;
+            }
+            renderLoadingScreen();
+            if (firstFrame) {
+                cout << "Loading screen shown after " << millisecondsSince(startCounter) << " ms" << endl;
+                firstFrame = false;
+            }
+            SDL_Delay(frame_delay);
+        }
+    }
 
-    // Load font
-    font = TTF_OpenFont("arial.ttf", 24);
-    if (!font) {
-        cerr << "Failed to load font: " << TTF_GetError() << endl;
+    if (!assetErrors.empty()) {
+        for (const auto& error : assetErrors) cerr << error << endl;
         cleanup();
         return 1;
     }
+    if (!running) {
+        cleanup();
+        return 0;
+    }
 
-    // Load background image
-    SDL_Surface* backgroundSurface = SDL_LoadBMP("47412.bmp");
-    if (!backgroundSurface) {
-        cerr << "Failed to load background image: " << SDL_GetError() << endl;
+    if (!uploadAssets()) {
+        cerr << "Failed to upload assets: " << SDL_GetError() << endl;
         cleanup();
         return 1;
     }
-    backgroundTexture = SDL_CreateTextureFromSurface(renderer, backgroundSurface);
-    SDL_FreeSurface(backgroundSurface);
-
-    // Load audio
-    bgMusic = Mix_LoadMUS("audio.mp3");
-    eatSound = Mix_LoadWAV("eating-sound-effect-36186.mp3");
-    gameOverSound = Mix_LoadWAV("game-over-arcade-6435.mp3");
-    if (!bgMusic || !eatSound || !gameOverSound) {
-        cerr << "Failed to load audio: " << Mix_GetError() << endl;
+
+    if (config().benchStartup) {
+        benchmarkStartup();
         cleanup();
-        return 1;
+        return 0;
     }
 
-    // Play background music
-    Mix_PlayMusic(bgMusic, -1);
+    // Settle the audio buffer size before anything starts playing
+    tuneAudioBuffer();
+    setEventSound(SoundEvent::Eat, eatSound);
+    setEventSound(SoundEvent::Bonus, eatSound);
+    setEventSound(SoundEvent::Death, gameOverSound);
+
+    // Play background music through the stream, from the baked PCM in the pack when
+    // there is some and otherwise from the track decoded at load time
+    if (bakedMusic) {
+        startMusicStream(bakedMusic, bakedMusicBytes, config().musicLookaheadMs,
+                         [](const void* range, size_t bytes) { assetPack.evict(range, bytes); });
+    } else if (musicChunk) {
+        startMusicStream(musicChunk->abuf, musicChunk->alen, config().musicLookaheadMs);
+    }
 
-    // Initialize game objects
-    vector<SnakeSegment> snake{{15, 15}};
-    SDL_Point food = {10, 10};
-    SDL_Point bonusFood = {-1, -1};
-    SDL_Keycode direction = SDLK_RIGHT;
-    bool bonusFoodActive = false;
+    applyPacing(config().latencyTest ? Pacing::Delay : config().pacing);
+
+    // The game itself runs on the simulation thread from here on
+    startSimulation();
+    uint32_t currentGame = 0;
+
+    // The idle check starts a game, minimises the window and measures how much CPU the
+    // process burns while it sits in the background. Run it with SDL_VIDEODRIVER=dummy.
+    Uint64 idleCheckStart = 0;
+    double idleCheckCpu = 0.0;
+    bool idleCheckFailed = false;
+    if (config().idleCheck) {
+        scene = Scene::Playing;
+        sendCommand(SimCommand::Resume);
+        SDL_Event minimise{};
+        minimise.type = SDL_WINDOWEVENT;
+        minimise.window.windowID = SDL_GetWindowID(window);
+        minimise.window.event = SDL_WINDOWEVENT_MINIMIZED;
+        SDL_PushEvent(&minimise);
+    }
 
-    // Initialize score texture
-    updateScoreTexture();
+    // Main loop: while playing, the simulation thread ticks at a fixed rate and this
+    // thread renders its latest snapshot as the pacing mode allows, interpolating from
+    // the tick before. The other scenes block in SDL_WaitEventTimeout and only
+    // redraw on events, and going to the background always leaves a paused scene.
+    const Uint64 perfFrequency = SDL_GetPerformanceFrequency();
+    const double tickSeconds = config().tickMs / 1000.0;
+    bool firstFrame = true;
+    bool redraw = true;
+    Uint64 presentedTick = 0;
 
-    // Main game loop
     while (running) {
+        const Scene previousScene = scene;
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        bool haveEvent = scene == Scene::Playing ? SDL_PollEvent(&event) : SDL_WaitEventTimeout(&event, idle_wait_ms);
+        for (; haveEvent; haveEvent = SDL_PollEvent(&event)) {
+            redraw = true;
             if (event.type == SDL_QUIT) {
                 running = false;
+            } else if (event.type == SDL_WINDOWEVENT) {
+                handleWindowEvent(event.window);
             } else if (event.type == SDL_KEYDOWN) {
-                switch (event.key.keysym.sym) {
-                    case SDLK_UP: if (direction != SDLK_DOWN) direction = SDLK_UP; break;
-                    case SDLK_DOWN: if (direction != SDLK_UP) direction = SDLK_DOWN; break;
-                    case SDLK_LEFT: if (direction != SDLK_RIGHT) direction = SDLK_LEFT; break;
-                    case SDLK_RIGHT: if (direction != SDLK_LEFT) direction = SDLK_RIGHT; break;
+                SDL_Keycode key = event.key.keysym.sym;
+                switch (scene) {
+                    case Scene::Menu:
+                    case Scene::GameOver:
+                        if (key == SDLK_RETURN || key == SDLK_SPACE) {
+                            sendCommand(SimCommand::Reset);
+                            ++currentGame;
+                            scene = Scene::Playing;
+                        } else if (key == SDLK_ESCAPE) {
+                            running = false;
+                        }
+                        break;
+                    case Scene::Playing:
+                        switch (key) {
+                            case SDLK_UP: sendCommand(SimCommand::TurnUp, event.key.timestamp); break;
+                            case SDLK_DOWN: sendCommand(SimCommand::TurnDown, event.key.timestamp); break;
+                            case SDLK_LEFT: sendCommand(SimCommand::TurnLeft, event.key.timestamp); break;
+                            case SDLK_RIGHT: sendCommand(SimCommand::TurnRight, event.key.timestamp); break;
+                            case SDLK_i: smoothMotion = !smoothMotion; break;
+                            case SDLK_a: sendCommand(SimCommand::ToggleAutopilot); break;
+                            case SDLK_p:
+                            case SDLK_ESCAPE: scene = Scene::Paused; break;
+                        }
+                        break;
+                    case Scene::Paused:
+                        if (key == SDLK_p || key == SDLK_ESCAPE || key == SDLK_SPACE) scene = Scene::Playing;
+                        else if (key == SDLK_q) running = false;
+                        break;
                 }
             }
         }
+        if (!running) break;
+        if (backgrounded && scene == Scene::Playing) scene = Scene::Paused;
+
+        if (config().idleCheck && backgrounded) {
+            if (idleCheckStart == 0) {
+                idleCheckStart = SDL_GetPerformanceCounter();
+                idleCheckCpu = processCpuSeconds();
+            } else if (millisecondsSince(idleCheckStart) >= idle_check_seconds * 1000.0) {
+                double usage = 100.0 * (processCpuSeconds() - idleCheckCpu) / (millisecondsSince(idleCheckStart) / 1000.0);
+                idleCheckFailed = usage >= idle_cpu_target;
+                cout << "Idle CPU: " << usage << "% (target < " << idle_cpu_target << "%) "
+                     << (idleCheckFailed ? "FAILED" : "ok") << endl;
+                break;
+            }
+        }
+
+        if (scene != previousScene) {
+            if (scene == Scene::Playing) {
+                sendCommand(SimCommand::Resume);
+                resetPacing();
+            }
+            else if (previousScene == Scene::Playing) sendCommand(SimCommand::Pause);
+        }
+
+        // Until the reset has gone through, the latest snapshot belongs to the last game
+        const GameSnapshot& snapshot = latestSnapshot();
+        const bool current = snapshot.game == currentGame;
+        if (scene == Scene::Playing && current && !snapshot.state.alive) {
+            scene = Scene::GameOver;
+            redraw = true;
+        }
+        if (scene == Scene::Playing && !current) {
+            SDL_Delay(1);
+            continue;
+        }
+        updateScoreText(snapshot.state.score);
+        float alpha = 1.0f;
+        if (scene == Scene::Playing && currentPacing() != Pacing::Step) {
+            alpha = float((SDL_GetPerformanceCounter() - snapshot.tickCounter) / (tickSeconds * perfFrequency));
+            alpha = min(alpha, 1.0f);
+        }
 
-        update(snake, food, bonusFood, direction, bonusFoodActive);
+        if (config().latencyTest) injectLatencyProbe(snapshot);
+
+        if (!windowVisible || (scene != Scene::Playing && !redraw)) continue;
+        if (scene == Scene::Playing && currentPacing() == Pacing::Step && !redraw && snapshot.tickCounter == presentedTick) {
+            SDL_Delay(1);
+            continue;
+        }
+        redraw = false;
+        presentedTick = snapshot.tickCounter;
 
         SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
         SDL_RenderClear(renderer);
-        SDL_RenderCopy(renderer, backgroundTexture, nullptr, nullptr);
-        render(snake, food, bonusFood);
-        SDL_RenderCopy(renderer, scoreTexture, nullptr, &scoreRect);
+        if (scene == Scene::Menu) {
+            renderMenu();
+        } else if (scene == Scene::GameOver) {
+            renderGameOver(snapshot.state.won);
+        } else {
+            SDL_RenderCopy(renderer, backgroundTexture, nullptr, nullptr);
+            render(snapshot.state, alpha);
+            drawText(renderer, fontAtlas, scoreText.c_str(), scorePosition.x, scorePosition.y, {51, 51, 0, 255});
+            if (snapshot.autopilot) {
+                const char* label = "AUTOPILOT";
+                drawText(renderer, fontAtlas, label, config().screenWidth - scorePosition.x - textWidth(fontAtlas, label), scorePosition.y, {51, 51, 0, 255});
+            }
+            if (scene == Scene::Paused) renderPaused();
+        }
         SDL_RenderPresent(renderer);
+        if (config().latencyTest && scene == Scene::Playing && current && checkLatencyProbe(snapshot)) break;
 
-        SDL_Delay(100);
+        if (firstFrame) {
+            cout << "Time to first frame: " << millisecondsSince(startCounter) << " ms" << endl;
+            firstFrame = false;
+        }
+
+        if (scene == Scene::Playing) paceFrame();
     }
 
+    reportMetrics(cout);
     cleanup();
-    return 0;
+    return idleCheckFailed ? 1 : 0;
+}
+
+SDL_RWops* openAsset(const char* name) {
+    if (assetPack.isOpen()) return assetPack.openAsset(name);
+    return SDL_RWFromFile(name, "rb");
+}
+
+BakedBlob findBaked(const string& name) {
+    BakedBlob blob;
+    if (assetPack.isOpen()) blob.data = assetPack.view(name.c_str(), &blob.size);
+    return blob;
+}
+
+// Effects come from baked PCM when it matches the opened device, otherwise they are decoded
+Mix_Chunk* loadSound(const char* name) {
+    BakedBlob baked = findBaked(string(name) + ".pcm");
+    if (baked.data) {
+        if (Mix_Chunk* chunk = loadBakedSound(baked.data, baked.size)) return chunk;
+    }
+    return Mix_LoadWAV_RW(openAsset(name), 1);
+}
+
+void loadAssets(ThreadPool& loader) {
+    auto fail = [](const string& message) {
+        lock_guard<mutex> lock(assetErrorMutex);
+        assetErrors.push_back(message);
+    };
+
+    loader.submit([fail] {
+        bakedFont = findBaked(config().font + ".atlas");
+        if (!bakedFont.data) {
+            TTF_Font* font = TTF_OpenFontRW(openAsset(config().font.c_str()), 1, atlas_point_size);
+            if (font) {
+                fontAtlasSurface = rasterizeFontAtlas(font, atlas_point_size, fontAtlasHeader);
+                TTF_CloseFont(font);
+            }
+            if (!fontAtlasSurface) fail(string("Failed to load font: ") + TTF_GetError());
+        }
+        assetsLoaded++;
+    });
+    loader.submit([fail] {
+        bakedBackground = findBaked(config().background + ".img");
+        if (!bakedBackground.data) {
+            backgroundSurface = SDL_LoadBMP_RW(openAsset(config().background.c_str()), 1);
+            if (!backgroundSurface) fail(string("Failed to load background image: ") + SDL_GetError());
+        }
+        assetsLoaded++;
+    });
+    // Without an audio device there is nothing to decode the sounds for
+    loader.submit([fail] {
+        if (!audioEnabled()) {
+            assetsLoaded++;
+            return;
+        }
+        BakedBlob baked = findBaked(config().music + ".pcm");
+        if (baked.data) bakedMusic = bakedSoundPcm(baked.data, baked.size, &bakedMusicBytes);
+        if (bakedMusic) {
+            assetsLoaded++;
+            return;
+        }
+        // Decoding the whole track here keeps the decoder out of the audio callback, at
+        // the cost of holding it in memory; make bake avoids both
+        musicChunk = Mix_LoadWAV_RW(openAsset(config().music.c_str()), 1);
+        if (!musicChunk) fail(string("Failed to load audio: ") + Mix_GetError());
+        assetsLoaded++;
+    });
+    loader.submit([fail] {
+        if (!audioEnabled()) {
+            assetsLoaded++;
+            return;
+        }
+        eatSound = loadSound(config().eatSound.c_str());
+        if (!eatSound) fail(string("Failed to load audio: ") + Mix_GetError());
+        assetsLoaded++;
+    });
+    loader.submit([fail] {
+        if (!audioEnabled()) {
+            assetsLoaded++;
+            return;
+        }
+        gameOverSound = loadSound(config().gameOverSound.c_str());
+        if (!gameOverSound) fail(string("Failed to load audio: ") + Mix_GetError());
+        assetsLoaded++;
+    });
 }
 
-void render(const vector<SnakeSegment>& snake, const SDL_Point& food, const SDL_Point& bonusFood) {
+// Create the textures for whatever the loader produced; must run on the render thread
+bool uploadAssets() {
+    if (bakedFont.data) {
+        if (!loadBakedFont(renderer, bakedFont.data, bakedFont.size, fontAtlas)) return false;
+    } else {
+        bool ok = createFontAtlas(renderer, fontAtlasHeader, fontAtlasSurface->pixels, fontAtlas);
+        SDL_FreeSurface(fontAtlasSurface);
+        fontAtlasSurface = nullptr;
+        if (!ok) return false;
+    }
+
+    if (bakedBackground.data) {
+        backgroundTexture = loadBakedImage(renderer, bakedBackground.data, bakedBackground.size);
+    } else {
+        backgroundTexture = SDL_CreateTextureFromSurface(renderer, backgroundSurface);
+        SDL_FreeSurface(backgroundSurface);
+        backgroundSurface = nullptr;
+    }
+    return backgroundTexture != nullptr;
+}
+
+// Times loading each asset from its source file against loading its baked form
+void benchmarkStartup() {
+    const int iterations = 10;
+    if (!findBaked(config().font + ".atlas").data) {
+        cerr << "No baked assets in " << config().assetPack << ", run make bake first" << endl;
+        return;
+    }
+
+    struct Case {
+        const char* name;
+        function<void()> raw;
+        function<void()> baked;
+    };
+    auto sound = [](const char* name) {
+        return Case{name,
+            [name] { Mix_FreeChunk(Mix_LoadWAV_RW(openAsset(name), 1)); },
+            [name] {
+                BakedBlob blob = findBaked(string(name) + ".pcm");
+                Mix_FreeChunk(loadBakedSound(blob.data, blob.size));
+            }};
+    };
+    vector<Case> cases = {
+        {config().font.c_str(),
+            [] {
+                TTF_Font* font = TTF_OpenFontRW(openAsset(config().font.c_str()), 1, atlas_point_size);
+                BakedFont header;
+                SDL_Surface* surface = rasterizeFontAtlas(font, atlas_point_size, header);
+                FontAtlas atlas;
+                createFontAtlas(renderer, header, surface->pixels, atlas);
+                SDL_DestroyTexture(atlas.texture);
+                SDL_FreeSurface(surface);
+                TTF_CloseFont(font);
+            },
+            [] {
+                BakedBlob blob = findBaked(config().font + ".atlas");
+                FontAtlas atlas;
+                loadBakedFont(renderer, blob.data, blob.size, atlas);
+                SDL_DestroyTexture(atlas.texture);
+            }},
+        {config().background.c_str(),
+            [] {
+                SDL_Surface* surface = SDL_LoadBMP_RW(openAsset(config().background.c_str()), 1);
+                SDL_DestroyTexture(SDL_CreateTextureFromSurface(renderer, surface));
+                SDL_FreeSurface(surface);
+            },
+            [] {
+                BakedBlob blob = findBaked(config().background + ".img");
+                SDL_DestroyTexture(loadBakedImage(renderer, blob.data, blob.size));
+            }},
+        sound(config().eatSound.c_str()),
+        sound(config().gameOverSound.c_str()),
+    };
+
+    auto average = [iterations](const function<void()>& load) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < iterations; ++i) load();
+        return millisecondsSince(start) / iterations;
+    };
+
+    double rawTotal = 0, bakedTotal = 0;
+    cout << fixed << setprecision(3);
+    cout << left << setw(32) << "asset" << right << setw(12) << "raw ms" << setw(12) << "baked ms" << endl;
+    for (const auto& c : cases) {
+        double raw = average(c.raw);
+        double baked = average(c.baked);
+        rawTotal += raw;
+        bakedTotal += baked;
+        cout << left << setw(32) << c.name << right << setw(12) << raw << setw(12) << baked << endl;
+    }
+    cout << left << setw(32) << "total" << right << setw(12) << rawTotal << setw(12) << bakedTotal << endl;
+}
+
+void renderLoadingScreen() {
+    SDL_Rect frame = {config().screenWidth / 4, config().screenHeight / 2 - 10, config().screenWidth / 2, 20};
+    SDL_Rect bar = {frame.x + 2, frame.y + 2, (frame.w - 4) * assetsLoaded.load() / asset_count, frame.h - 4};
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderClear(renderer);
+    SDL_SetRenderDrawColor(renderer, 0, 102, 204, 255);
+    SDL_RenderDrawRect(renderer, &frame);
+    SDL_RenderFillRect(renderer, &bar);
+    SDL_RenderPresent(renderer);
+}
+
+double millisecondsSince(Uint64 counter) {
+    return (SDL_GetPerformanceCounter() - counter) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void render(const GameState& game, float alpha) {
+    const int block = config().blockSize;
+
     // Render snake
-    for (const auto& segment : snake) {
-        SDL_Rect rect = {segment.x * block_size, segment.y * block_size, block_size, block_size};
-        SDL_SetRenderDrawColor(renderer, 0, 102, 204, 255);
-        SDL_RenderFillRect(renderer, &rect);
+    if (smoothMotion) {
+        renderSmoothSnake(game, alpha);
+    } else {
+        for (const auto& segment : game.snake) {
+            SDL_Rect rect = {segment.x * block, segment.y * block, block, block};
+            SDL_SetRenderDrawColor(renderer, 0, 102, 204, 255);
+            SDL_RenderFillRect(renderer, &rect);
+        }
     }
 
-    // Render food
-    SDL_Rect foodRect = {food.x * block_size, food.y * block_size, block_size, block_size};
-    SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-    SDL_RenderFillRect(renderer, &foodRect);
+    // Render food; it's at -1, -1 when the board is full and none could be placed
+    const SDL_Point& food = game.food;
+    const SDL_Point& bonusFood = game.bonusFood;
+    if (food.x != -1 && food.y != -1) {
+        SDL_Rect foodRect = {food.x * block, food.y * block, block, block};
+        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+        SDL_RenderFillRect(renderer, &foodRect);
+    }
 
     // Render bonus food
     if (bonusFood.x != -1 && bonusFood.y != -1) {
-        SDL_Rect bonusFoodRect = {bonusFood.x * block_size, bonusFood.y * block_size, block_size, block_size};
+        SDL_Rect bonusFoodRect = {bonusFood.x * block, bonusFood.y * block, block, block};
         SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
         SDL_RenderFillRect(renderer, &bonusFoodRect);
     }
 
     // Render obstacles
     SDL_SetRenderDrawColor(renderer, 0, 51, 0, 255);
-    SDL_RenderFillRect(renderer, &obstacle1);
-    SDL_RenderFillRect(renderer, &obstacle2);
-    SDL_RenderFillRect(renderer, &obstacle3);
+    const vector<SDL_Rect>& obstacles = config().obstacles;
+    SDL_RenderFillRects(renderer, obstacles.data(), (int)obstacles.size());
 }
 
-void update(vector<SnakeSegment>& snake, SDL_Point& food, SDL_Point& bonusFood, SDL_Keycode& direction, bool& bonusFoodActive) {
-    int headX = snake.front().x;
-    int headY = snake.front().y;
-
-    switch (direction) {
-        case SDLK_UP: headY--; break;
-        case SDLK_DOWN: headY++; break;
-        case SDLK_LEFT: headX--; break;
-        case SDLK_RIGHT: headX++; break;
-    }
+SDL_FPoint interpolateCell(const SnakeSegment& from, const SnakeSegment& to, float alpha) {
+    float dx = wrappedDelta(from.x, to.x, config().gridWidth);
+    float dy = wrappedDelta(from.y, to.y, config().gridHeight);
+    return {to.x - dx * (1.0f - alpha), to.y - dy * (1.0f - alpha)};
+}
 
-    // Wrap around the screen
-    if (headX < 0) headX = screen_width / block_size - 1;
-    if (headX >= screen_width / block_size) headX = 0;
-    if (headY < 0) headY = screen_height / block_size - 1;
-    if (headY >= screen_height / block_size) headY = 0;
+SDL_FPoint normalized(float x, float y) {
+    float len = sqrtf(x * x + y * y);
+    if (len < 1e-6f) return {1.0f, 0.0f};
+    return {x / len, y / len};
+}
 
-    if (checkCollision(snake, headX, headY)) {
-        Mix_PlayChannel(-1, gameOverSound, 0);
-        displayGameOver();
-        running = false;
-        return;
+// Extrude the centre line in snakeRun (cell units) into a strip half a block wide on
+// either side, capped half a block past both ends, and append it to the geometry buffers
+void flushSnakeRun(SDL_FPoint heading) {
+    if (snakeRun.empty()) return;
+    if (snakeRun.size() == 1) {
+        SDL_FPoint p = snakeRun[0];
+        snakeRun.push_back({p.x - heading.x * 1e-3f, p.y - heading.y * 1e-3f});
     }
 
-    SnakeSegment newHead = {headX, headY};
-    if (headX == food.x && headY == food.y) {
-        Mix_PlayChannel(-1, eatSound, 0);
-        snake.insert(snake.begin(), newHead);
-        food.x = rand() % (screen_width / block_size);
-        food.y = rand() % (screen_height / block_size);
-        score++;
-        updateScoreTexture();
-
-        if (score % 5 == 0 && !bonusFoodActive) {
-            spawnBonusFood(bonusFood, snake, food);
-            bonusFoodActive = true;
+    size_t n = snakeRun.size();
+    SDL_FPoint first = normalized(snakeRun[0].x - snakeRun[1].x, snakeRun[0].y - snakeRun[1].y);
+    SDL_FPoint last = normalized(snakeRun[n - 1].x - snakeRun[n - 2].x, snakeRun[n - 1].y - snakeRun[n - 2].y);
+    snakeRun[0].x += first.x * 0.5f;
+    snakeRun[0].y += first.y * 0.5f;
+    snakeRun[n - 1].x += last.x * 0.5f;
+    snakeRun[n - 1].y += last.y * 0.5f;
+
+    const SDL_Color color = {0, 102, 204, 255};
+    const float block = (float)config().blockSize;
+    int base = (int)snakeVertices.size();
+    for (size_t i = 0; i < n; ++i) {
+        SDL_FPoint in = i > 0 ? normalized(snakeRun[i].x - snakeRun[i - 1].x, snakeRun[i].y - snakeRun[i - 1].y)
+                              : normalized(snakeRun[1].x - snakeRun[0].x, snakeRun[1].y - snakeRun[0].y);
+        SDL_FPoint out = i + 1 < n ? normalized(snakeRun[i + 1].x - snakeRun[i].x, snakeRun[i + 1].y - snakeRun[i].y) : in;
+
+        // Mitre the join so corners come out square
+        SDL_FPoint normal = normalized(-(in.y + out.y), in.x + out.x);
+        float cosHalf = normal.x * -in.y + normal.y * in.x;
+        float extent = 0.5f / max(cosHalf, 0.25f);
+
+        float cx = (snakeRun[i].x + 0.5f) * block;
+        float cy = (snakeRun[i].y + 0.5f) * block;
+        float ox = normal.x * extent * block;
+        float oy = normal.y * extent * block;
+        snakeVertices.push_back({{cx + ox, cy + oy}, color, {0, 0}});
+        snakeVertices.push_back({{cx - ox, cy - oy}, color, {0, 0}});
+
+        if (i > 0) {
+            int v = base + 2 * (int)i;
+            snakeIndices.insert(snakeIndices.end(), {v - 2, v - 1, v, v - 1, v + 1, v});
         }
-    } else if (bonusFoodActive && headX == bonusFood.x && headY == bonusFood.y) {
-        Mix_PlayChannel(-1, eatSound, 0);
-        snake.insert(snake.begin(), newHead);
-        score += 10;
-        updateScoreTexture();
-        bonusFoodActive = false;
-        bonusFood = {-1, -1};
-    } else {
-        snake.insert(snake.begin(), newHead);
-        snake.pop_back();
     }
+    snakeRun.clear();
 }
 
-bool checkCollision(const vector<SnakeSegment>& snake, int x, int y) {
-    for (size_t i = 1; i < snake.size(); ++i) {
-        if (snake[i].x == x && snake[i].y == y) return true;
+void renderSmoothSnake(const GameState& game, float alpha) {
+    const SnakeBody& snake = game.snake;
+    const SnakeSegment& prevHead = game.prevHead;
+    const SnakeSegment& prevTail = game.prevTail;
+    const int gridW = config().gridWidth;
+    const int gridH = config().gridHeight;
+
+    // The buffers keep their capacity, so after the first few frames this allocates nothing
+    snakeRun.clear();
+    snakeVertices.clear();
+    snakeIndices.clear();
+
+    // Centre line from the interpolated head, through every settled segment, to the
+    // interpolated tail. Where the body crosses a screen edge the strip is broken and both
+    // halves are extended one cell past the edge so it slides in and out smoothly.
+    SDL_FPoint head = interpolateCell(prevHead, snake.front(), alpha);
+    SDL_FPoint heading = normalized(wrappedDelta(prevHead.x, snake.front().x, gridW),
+                                    wrappedDelta(prevHead.y, snake.front().y, gridH));
+    SDL_FPoint previous = head;
+    snakeRun.push_back(head);
+
+    size_t count = snake.size() + 1;
+    for (size_t i = 1; i < count; ++i) {
+        SDL_FPoint p = i < snake.size() ? SDL_FPoint{(float)snake[i].x, (float)snake[i].y}
+                                        : interpolateCell(prevTail, snake.back(), alpha);
+        float dx = wrappedDelta(previous.x, p.x, gridW);
+        float dy = wrappedDelta(previous.y, p.y, gridH);
+        if (fabsf(dx) + fabsf(dy) < 1e-4f) continue;
+
+        if (dx != p.x - previous.x || dy != p.y - previous.y) {
+            snakeRun.push_back({previous.x + dx, previous.y + dy});
+            flushSnakeRun(heading);
+            snakeRun.push_back({p.x - dx, p.y - dy});
+        }
+        snakeRun.push_back(p);
+        previous = p;
     }
-    SDL_Rect headRect = {x * block_size, y * block_size, block_size, block_size};
-    if (SDL_HasIntersection(&headRect, &obstacle1) ||
-        SDL_HasIntersection(&headRect, &obstacle2) ||
-        SDL_HasIntersection(&headRect, &obstacle3)) return true;
-    return false;
+    flushSnakeRun(heading);
+
+    // SDL only takes indexed triangle lists, so the strip is unrolled into one index buffer
+    // and the whole body goes out in a single draw call
+    SDL_RenderGeometry(renderer, nullptr, snakeVertices.data(), (int)snakeVertices.size(),
+                       snakeIndices.data(), (int)snakeIndices.size());
 }
 
-void spawnBonusFood(SDL_Point& bonusFood, const vector<SnakeSegment>& snake, const SDL_Point& food) {
-    bool valid;
-    do {
-        valid = true;
-        bonusFood.x = rand() % (screen_width / block_size);
-        bonusFood.y = rand() % (screen_height / block_size);
+void updateScoreText(int score) {
+    if (score == shownScore) return;
+    shownScore = score;
+    scoreText = "Score: " + to_string(score);
+}
 
-        for (const auto& segment : snake) {
-            if (segment.x == bonusFood.x && segment.y == bonusFood.y) {
-                valid = false;
-                break;
-            }
-        }
+void renderCentredText(const char* text, int y, SDL_Color color) {
+    drawText(renderer, fontAtlas, text, (config().screenWidth - textWidth(fontAtlas, text)) / 2, y, color);
+}
 
-        if (bonusFood.x == food.x && bonusFood.y == food.y) {
-            valid = false;
-        }
+void renderMenu() {
+    SDL_RenderCopy(renderer, backgroundTexture, nullptr, nullptr);
+    renderCentredText("SNAKE", config().screenHeight / 2 - fontAtlas.lineHeight * 2, {0, 102, 204, 255});
+    renderCentredText("Press Enter to start", config().screenHeight / 2, {255, 255, 255, 255});
+}
 
-        SDL_Rect bonusRect = {bonusFood.x * block_size, bonusFood.y * block_size, block_size, block_size};
-        if (SDL_HasIntersection(&bonusRect, &obstacle1) ||
-            SDL_HasIntersection(&bonusRect, &obstacle2) ||
-            SDL_HasIntersection(&bonusRect, &obstacle3)) {
-            valid = false;
-        }
-    } while (!valid);
+void renderPaused() {
+    SDL_Rect screen = {0, 0, config().screenWidth, config().screenHeight};
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(renderer, &screen);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    renderCentredText("PAUSED", config().screenHeight / 2 - fontAtlas.lineHeight, {255, 255, 255, 255});
+    renderCentredText("Press P to resume, Q to quit", config().screenHeight / 2 + fontAtlas.lineHeight, {255, 255, 255, 255});
 }
 
-void updateScoreTexture() {
-    string scoreText = "Score: " + to_string(score);
-    SDL_Color textColor = {51, 51, 0, 255};
-    SDL_Surface* surface = TTF_RenderText_Solid(font, scoreText.c_str(), textColor);
-    if (scoreTexture) SDL_DestroyTexture(scoreTexture);
-    scoreTexture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
-    SDL_QueryTexture(scoreTexture, nullptr, nullptr, &scoreRect.w, &scoreRect.h);
+void renderGameOver(bool won) {
+    renderCentredText(won ? "BOARD CLEARED" : "GAME OVER", (config().screenHeight - fontAtlas.lineHeight) / 2 - fontAtlas.lineHeight, {255, 0, 0, 255});
+    renderCentredText(scoreText.c_str(), (config().screenHeight - fontAtlas.lineHeight) / 2, {255, 255, 255, 255});
+    renderCentredText("Press Enter to play again, Esc to quit", (config().screenHeight - fontAtlas.lineHeight) / 2 + 2 * fontAtlas.lineHeight, {255, 255, 255, 255});
 }
 
-void displayGameOver() {
-    SDL_Color textColor = {255, 0, 0, 255};
-    SDL_Surface* surface = TTF_RenderText_Solid(font, "GAME OVER", textColor);
-    SDL_Texture* gameOverTexture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
+void handleWindowEvent(const SDL_WindowEvent& event) {
+    switch (event.event) {
+        case SDL_WINDOWEVENT_MINIMIZED:
+        case SDL_WINDOWEVENT_HIDDEN: windowVisible = false; break;
+        case SDL_WINDOWEVENT_SHOWN:
+        case SDL_WINDOWEVENT_EXPOSED:
+        case SDL_WINDOWEVENT_RESTORED:
+        case SDL_WINDOWEVENT_MAXIMIZED: windowVisible = true; break;
+        case SDL_WINDOWEVENT_FOCUS_LOST: windowFocused = false; break;
+        case SDL_WINDOWEVENT_FOCUS_GAINED: windowFocused = true; break;
+        default: return;
+    }
 
-    int w, h;
-    SDL_QueryTexture(gameOverTexture, nullptr, nullptr, &w, &h);
-    SDL_Rect rect = {(screen_width - w) / 2, (screen_height - h) / 2, w, h};
+    // Music comes back when the window does; the game waits for the player to unpause
+    bool nowBackgrounded = !windowVisible || !windowFocused;
+    if (nowBackgrounded == backgrounded) return;
+    backgrounded = nowBackgrounded;
+    setMusicStreamPaused(backgrounded);
+}
 
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
-    SDL_RenderCopy(renderer, gameOverTexture, nullptr, &rect);
-    SDL_RenderPresent(renderer);
+void applyPacing(Pacing mode) {
+    SDL_DisplayMode display;
+    int refreshHz = SDL_GetWindowDisplayMode(window, &display) == 0 ? display.refresh_rate : 0;
+    setPacing(renderer, mode, refreshHz);
+}
+
+void pushKey(SDL_Keycode key) {
+    SDL_Event event{};
+    event.type = SDL_KEYDOWN;
+    event.key.windowID = SDL_GetWindowID(window);
+    event.key.state = SDL_PRESSED;
+    event.key.keysym.sym = key;
+    SDL_PushEvent(&event);
+}
 
-    SDL_Delay(3000);
-    SDL_DestroyTexture(gameOverTexture);
+void injectLatencyProbe(const GameSnapshot& snapshot) {
+    // Start (or restart, after running into something) a game
+    if (scene == Scene::Menu || scene == Scene::GameOver) {
+        latencyTest.waiting = false;
+        if (!SDL_HasEvent(SDL_KEYDOWN)) pushKey(SDLK_RETURN);
+        return;
+    }
+    if (scene != Scene::Playing || latencyTest.waiting || SDL_GetPerformanceCounter() < latencyTest.nextProbe) return;
+
+    // Always turn at right angles so the turn can't be dropped as a repeat or reversal
+    bool horizontal = snapshot.state.direction == SDLK_LEFT || snapshot.state.direction == SDLK_RIGHT;
+    bool flip = latencyTest.probes % 2;
+    pushKey(horizontal ? (flip ? SDLK_UP : SDLK_DOWN) : (flip ? SDLK_LEFT : SDLK_RIGHT));
+    latencyTest.waiting = true;
+    latencyTest.pushedAt = SDL_GetPerformanceCounter();
+    latencyTest.baseline = snapshot.turnsApplied;
+}
+
+// Called after each present while playing; returns true once every mode is done
+bool checkLatencyProbe(const GameSnapshot& snapshot) {
+    if (!latencyTest.waiting || snapshot.turnsApplied == latencyTest.baseline) return false;
+
+    latencyTest.results[latencyTest.mode].record(millisecondsSince(latencyTest.pushedAt) * 1000.0);
+    latencyTest.effective[latencyTest.mode] = currentPacing();
+    latencyTest.waiting = false;
+    latencyTest.nextProbe = SDL_GetPerformanceCounter() + SDL_GetPerformanceFrequency() * latency_probe_interval_ms / 1000;
+    if (++latencyTest.probes < latency_probes_per_mode) return false;
+
+    latencyTest.probes = 0;
+    if (++latencyTest.mode < pacing_count) {
+        applyPacing(Pacing(latencyTest.mode));
+        return false;
+    }
+
+    cout << "Input-to-present latency, " << latency_probes_per_mode << " turns per pacing mode:" << endl;
+    for (int i = 0; i < pacing_count; ++i) {
+        string name = pacingName(Pacing(i));
+        if (latencyTest.effective[i] != Pacing(i)) name += string(" (as ") + pacingName(latencyTest.effective[i]) + ")";
+        latencyTest.results[i].report(cout, name.c_str());
+    }
+    return true;
 }
 
 void cleanup() {
-    if (scoreTexture) SDL_DestroyTexture(scoreTexture);
+    stopSimulation();
+    stopMusicStream();
+    closeAudio();
+    if (fontAtlas.texture) SDL_DestroyTexture(fontAtlas.texture);
+    if (fontAtlasSurface) SDL_FreeSurface(fontAtlasSurface);
     if (backgroundTexture) SDL_DestroyTexture(backgroundTexture);
-    if (bgMusic) Mix_FreeMusic(bgMusic);
+    if (backgroundSurface) SDL_FreeSurface(backgroundSurface);
+    if (musicChunk) Mix_FreeChunk(musicChunk);
     if (eatSound) Mix_FreeChunk(eatSound);
     if (gameOverSound) Mix_FreeChunk(gameOverSound);
-    if (font) TTF_CloseFont(font);
     if (renderer) SDL_DestroyRenderer(renderer);
     if (window) SDL_DestroyWindow(window);
     TTF_Quit();
-    Mix_CloseAudio();
     SDL_Quit();
+    assetPack.close();
 }
@@ -0,0 +1,212 @@
+#include "mcts.h"
+#include <algorithm>
+#include <cmath>
+#include "config.h"
+#include "metrics.h"
+using namespace std;
+
+namespace {
+
+const int node_capacity = 1 << 17;
+const int max_tree_depth = 64;
+const int playout_ticks = 40;
+const double exploration = 1.4;
+const double discount = 0.9;
+
+// Most playouts a node takes over from the transposition table, so stale results
+// can't outweigh what this search finds
+const uint32_t max_prior_visits = 16;
+
+// Moves that neither reverse nor collide on the next tick
+int safeMoves(const GameState& game, int safe[4]) {
+    const SDL_Keycode reverse = oppositeDirection(game.direction);
+    const SnakeSegment head = game.snake.front();
+    int count = 0;
+    for (int m = 0; m < 4; ++m) {
+        if (move_directions[m] == reverse) continue;
+        const SnakeSegment next = step(head, move_directions[m]);
+        if (!checkCollision(game, next.x, next.y)) safe[count++] = m;
+    }
+    return count;
+}
+
+// Plays safe moves, mostly the one nearest the food and otherwise any at random, and
+// scores the result from 0 to 1: half for still being alive, half for what was eaten
+// since the search began, discounted by how many ticks it took to get there.
+double playout(GameState& game, const GameState& root, uint64_t& rng) {
+    int safe[4];
+    double weight = 1.0;
+    for (uint64_t t = root.ticks; t < game.ticks; ++t) weight *= discount;
+    double eaten = game.score != root.score ? weight : 0.0;
+    for (int t = 0; t < playout_ticks && game.alive; ++t) {
+        int count = safeMoves(game, safe);
+        if (count) {
+            const uint64_t roll = xorshift64(rng);
+            int chosen = safe[(roll >> 8) % count];
+            if (roll % 4 != 0) {
+                int bestDistance = -1;
+                for (int i = 0; i < count; ++i) {
+                    int distance = wrappedDistance(step(game.snake.front(), move_directions[safe[i]]), game.food);
+                    if (bestDistance < 0 || distance < bestDistance) {
+                        bestDistance = distance;
+                        chosen = safe[i];
+                    }
+                }
+            }
+            turn(game, move_directions[chosen]);
+        }
+        const int before = game.score;
+        update(game);
+        weight *= discount;
+        if (game.score != before) eaten += weight;
+    }
+    if (game.won) return 1.0;
+    return (game.alive ? 0.5 : 0.0) + 0.5 * min(1.0, eaten);
+}
+
+} // namespace
+
+int MctsPlanner::allocate() {
+    int index = nodeCount.fetch_add(1, memory_order_relaxed);
+    if (index >= node_capacity) return -1;
+    Node& node = nodes[index];
+    node.visits.store(0, memory_order_relaxed);
+    node.reward.store(0, memory_order_relaxed);
+    for (auto& child : node.children) child.store(-1, memory_order_relaxed);
+    return index;
+}
+
+SDL_Keycode MctsPlanner::plan(const GameState& game) {
+    int safe[4];
+    const int choices = safeMoves(game, safe);
+    if (choices == 0) return 0;
+    if (choices == 1) return move_directions[safe[0]];
+
+    const Config& settings = config();
+    unsigned threads = searchThreads ? searchThreads : settings.searchThreads;
+    if (threads == 0) threads = max(1u, thread::hardware_concurrency());
+    if (!nodes) nodes.reset(new Node[node_capacity]);
+    if (threads > 1 && !pool) pool.reset(new ThreadPool(threads));
+    if (!table) table.reset(new TranspositionTable(settings.tableMb));
+    table->age();
+    forks.resize(threads);
+
+    nodeCount.store(0, memory_order_relaxed);
+    allocate();
+
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const Uint64 deadline = start + settings.searchBudgetMs * SDL_GetPerformanceFrequency() / 1000;
+    uint64_t seeds = game.rng ^ (game.ticks * 0x9E3779B97F4A7C15ull) ^ (uintptr_t)this;
+    if (threads == 1) {
+        search(game, forks[0], deadline, xorshift64(seeds) | 1);
+    } else {
+        for (unsigned t = 0; t < threads; ++t) {
+            const uint64_t seed = xorshift64(seeds) | 1;
+            pool->submit([this, &game, t, deadline, seed] { search(game, forks[t], deadline, seed); });
+        }
+        pool->wait();
+    }
+    metrics.searchMicros += (SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency();
+
+    int best = safe[0];
+    int bestVisits = -1;
+    for (int i = 0; i < choices; ++i) {
+        int child = nodes[0].children[safe[i]].load(memory_order_acquire);
+        int visits = child < 0 ? 0 : nodes[child].visits.load(memory_order_relaxed);
+        if (visits > bestVisits) {
+            best = safe[i];
+            bestVisits = visits;
+        }
+    }
+    return move_directions[best];
+}
+
+void MctsPlanner::clear() {
+    if (table) table->clear();
+}
+
+void MctsPlanner::search(const GameState& root, GameState& fork, Uint64 deadline, uint64_t seed) {
+    uint64_t rng = seed;
+    uint64_t rollouts = 0;
+    uint64_t tableHits = 0;
+    int path[max_tree_depth + 1];
+    int safe[4];
+
+    while (SDL_GetPerformanceCounter() < deadline) {
+        fork = root;
+        fork.muted = true;
+        fork.rng = xorshift64(rng) | 1;
+
+        int node = 0;
+        int depth = 0;
+        nodes[0].visits.fetch_add(1, memory_order_relaxed);
+        path[depth++] = 0;
+
+        while (fork.alive && depth <= max_tree_depth) {
+            Node& current = nodes[node];
+            const int count = safeMoves(fork, safe);
+            if (count == 0) break;
+
+            // Expand the first move nobody has tried from here yet
+            int chosen = -1;
+            int child = -1;
+            for (int i = 0; i < count && chosen < 0; ++i) {
+                if (current.children[safe[i]].load(memory_order_acquire) < 0) chosen = safe[i];
+            }
+            const bool expanding = chosen >= 0;
+            if (expanding) {
+                turn(fork, move_directions[chosen]);
+                update(fork);
+                child = allocate();
+                if (child >= 0) {
+                    TableEntry known;
+                    if (table->probe(fork.hash, known)) {
+                        const uint32_t visits = min(known.visits, max_prior_visits);
+                        nodes[child].visits.store(visits, memory_order_relaxed);
+                        nodes[child].reward.store(llround(known.value / 65535.0 * 1e6 * visits), memory_order_relaxed);
+                        ++tableHits;
+                    }
+                    int expected = -1;
+                    if (!current.children[chosen].compare_exchange_strong(expected, child, memory_order_acq_rel)) child = expected;
+                }
+            } else {
+                const double logParent = log((double)max(1, current.visits.load(memory_order_relaxed)));
+                double bestScore = -1.0;
+                for (int i = 0; i < count; ++i) {
+                    const int candidate = current.children[safe[i]].load(memory_order_acquire);
+                    const int visits = max(1, nodes[candidate].visits.load(memory_order_relaxed));
+                    const double mean = nodes[candidate].reward.load(memory_order_relaxed) / 1e6 / visits;
+                    const double score = mean + exploration * sqrt(logParent / visits);
+                    if (score > bestScore) {
+                        bestScore = score;
+                        chosen = safe[i];
+                        child = candidate;
+                    }
+                }
+                turn(fork, move_directions[chosen]);
+                update(fork);
+            }
+
+            // A full pool stops the tree growing; the playout carries on from here
+            if (child < 0) break;
+            node = child;
+            nodes[node].visits.fetch_add(1, memory_order_relaxed);
+            path[depth++] = node;
+            if (expanding) break;
+        }
+
+        const uint64_t leaf = fork.hash;
+        const double result = playout(fork, root, rng);
+        TableEntry entry;
+        if (!table->probe(leaf, entry)) entry = TableEntry();
+        entry.value = (uint16_t)lround((entry.value * (double)entry.visits + result * 65535.0) / (entry.visits + 1.0));
+        if (entry.visits < UINT32_MAX) ++entry.visits;
+        table->store(leaf, entry);
+
+        const int64_t reward = llround(result * 1e6);
+        for (int i = 0; i < depth; ++i) nodes[path[i]].reward.fetch_add(reward, memory_order_relaxed);
+        ++rollouts;
+    }
+    metrics.searchRollouts += rollouts;
+    metrics.searchTableHits += tableHits;
+}
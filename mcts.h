@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "game.h"
+#include "threadpool.h"
+#include "transposition.h"
+
+// Monte Carlo tree search over the snake's moves, run by several threads at once for
+// config().searchBudgetMs. Every iteration forks the game, walks the shared tree down
+// by UCT replaying each move with update(), adds one node, and finishes with a random
+// playout on the same engine, bonus food and all. The fork gets a fresh food seed
+// each time, so the search plans against food it can't foresee rather than reading
+// the game's own generator.
+//
+// Threads share the tree without locks. Nodes come from a pool with an atomic bump
+// counter, children are claimed by compare-and-swap, and statistics are atomic adds.
+// A thread counts its visit on the way down and its reward on the way back, so a path
+// under evaluation looks like a loss to the others (virtual loss) and they spread out.
+//
+// Playout results are also kept in a transposition table by position hash, which
+// outlives the tree. A node whose position was scored before, on another branch or
+// while planning an earlier move, starts from those results instead of from nothing.
+class MctsPlanner {
+public:
+    // threads overrides config().searchThreads when it isn't 0. Pass 1 from inside a
+    // thread pool that already keeps every core busy.
+    explicit MctsPlanner(unsigned threads = 0) : searchThreads(threads) {}
+
+    // Most visited move, or 0 when every move dies on the spot
+    SDL_Keycode plan(const GameState& game);
+
+    // Forgets the transposition table, so the next game doesn't start from this one's
+    void clear();
+
+private:
+    struct Node {
+        std::atomic<int> visits;
+        std::atomic<int64_t> reward; // Sum of playout rewards, in millionths
+        std::atomic<int> children[4]; // Node index per move, -1 until expanded
+    };
+
+    int allocate();
+    void search(const GameState& root, GameState& fork, Uint64 deadline, uint64_t seed);
+
+    unsigned searchThreads;
+    std::unique_ptr<Node[]> nodes;
+    std::atomic<int> nodeCount{0};
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<TranspositionTable> table;
+    std::vector<GameState> forks; // One per thread, so playouts reuse their buffers
+};
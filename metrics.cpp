@@ -0,0 +1,107 @@
+#include "metrics.h"
+#include <algorithm>
+#include <iomanip>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <ctime>
+#endif
+using namespace std;
+
+Metrics metrics;
+
+int LatencyHistogram::bucketFor(uint64_t micros) {
+    if (micros < 16) return (int)micros;
+    int log2 = 63 - __builtin_clzll(micros);
+    int bucket = 16 + (log2 - 4) * 8 + (int)((micros >> (log2 - 3)) & 7);
+    return bucket < bucket_count ? bucket : bucket_count - 1;
+}
+
+uint64_t LatencyHistogram::bucketLimit(int bucket) {
+    if (bucket < 16) return (uint64_t)bucket;
+    int log2 = (bucket - 16) / 8 + 4;
+    uint64_t sub = (uint64_t)(bucket - 16) % 8;
+    return ((8 + sub + 1) << (log2 - 3)) - 1;
+}
+
+void LatencyHistogram::record(double microseconds) {
+    uint64_t micros = microseconds > 0 ? (uint64_t)microseconds : 0;
+    buckets[bucketFor(micros)].fetch_add(1, memory_order_relaxed);
+    samples.fetch_add(1, memory_order_relaxed);
+    sumMicros.fetch_add(micros, memory_order_relaxed);
+    uint64_t seen = maxMicros.load(memory_order_relaxed);
+    while (micros > seen && !maxMicros.compare_exchange_weak(seen, micros, memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) bucket.store(0, memory_order_relaxed);
+    samples.store(0, memory_order_relaxed);
+    sumMicros.store(0, memory_order_relaxed);
+    maxMicros.store(0, memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    uint64_t n = count();
+    return n ? (double)sumMicros.load(memory_order_relaxed) / n : 0.0;
+}
+
+double LatencyHistogram::percentile(double fraction) const {
+    uint64_t n = count();
+    if (n == 0) return 0.0;
+    uint64_t target = (uint64_t)(fraction * (n - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < bucket_count; ++i) {
+        seen += buckets[i].load(memory_order_relaxed);
+        if (seen >= target) return min((double)bucketLimit(i), max());
+    }
+    return max();
+}
+
+void LatencyHistogram::report(ostream& out, const char* name) const {
+    out << "  " << left << setw(28) << name << right;
+    if (count() == 0) {
+        out << " no samples" << endl;
+        return;
+    }
+    out << fixed << setprecision(0)
+        << " n=" << count() << " mean=" << mean() << "us p50=" << percentile(0.50) << "us p99="
+        << percentile(0.99) << "us max=" << max() << "us" << endl;
+}
+
+void reportMetrics(ostream& out) {
+    out << "Metrics:" << endl;
+    out << "  audio buffer                 " << metrics.audioBufferSamples.load() << " samples" << endl;
+    out << "  audio callbacks              " << metrics.audioCallbacks.load() << " (" << metrics.lateAudioCallbacks.load() << " late)" << endl;
+    out << "  voices stolen                " << metrics.voicesStolen.load() << endl;
+    metrics.audioTriggerLatency.report(out, "audio trigger-to-output");
+    out << "  music lookahead              " << metrics.musicLookaheadSamples.load() << " samples" << endl;
+    out << "  music underruns              " << metrics.musicUnderruns.load() << " (" << metrics.musicUnderrunSamples.load() << " samples)" << endl;
+    metrics.tickJitter.report(out, "simulation tick jitter");
+    metrics.inputLatency.report(out, "input-to-tick latency");
+    out << "  turns dropped                " << metrics.droppedTurns.load() << endl;
+    metrics.autopilotPlan.report(out, "autopilot plan time");
+    out << "  path plans                   " << metrics.pathPlans.load() << " (" << metrics.pathFallbacks.load() << " left to greedy, "
+        << metrics.pathSearchesCapped.load() << " capped)" << endl;
+    out << "  search rollouts              " << metrics.searchRollouts.load() << " (" << fixed << setprecision(0)
+        << metrics.searchRollouts.load() / max(metrics.searchMicros.load() / 1e6, 1e-6) << "/s, " << metrics.searchTableHits.load() << " table hits)" << endl;
+    out << "  network inferences           " << metrics.inferences.load() << " (" << fixed << setprecision(0)
+        << metrics.inferences.load() / max(metrics.inferenceMicros.load() / 1e6, 1e-6) << "/s)" << endl;
+    out << "  frames presented             " << metrics.framesPresented.load() << " (" << metrics.missedFrameDeadlines.load() << " missed deadline)" << endl;
+    metrics.frameInterval.report(out, "frame interval");
+}
+
+double processCpuSeconds() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& time) { return (uint64_t(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) / 1e7;
+#else
+    timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
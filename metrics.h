@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+// Lock-free latency histogram. Values are bucketed log-linearly in microseconds
+// (exact below 16 us, then eight buckets per power of two), so recording is a couple
+// of relaxed atomic adds and percentiles are accurate to within about 12%.
+class LatencyHistogram {
+public:
+    void record(double microseconds);
+    void reset();
+
+    uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+    double mean() const;
+    double max() const { return (double)maxMicros.load(std::memory_order_relaxed); }
+    double percentile(double fraction) const;
+    void report(std::ostream& out, const char* name) const;
+
+private:
+    static const int bucket_count = 16 + 8 * 60;
+    static int bucketFor(uint64_t micros);
+    static uint64_t bucketLimit(int bucket);
+
+    std::atomic<uint64_t> buckets[bucket_count] = {};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> sumMicros{0};
+    std::atomic<uint64_t> maxMicros{0};
+};
+
+// Process-wide counters, written from any thread and printed on exit
+struct Metrics {
+    // Audio
+    std::atomic<int> audioBufferSamples{0};
+    std::atomic<uint64_t> audioCallbacks{0};
+    std::atomic<uint64_t> lateAudioCallbacks{0};
+    std::atomic<uint64_t> voicesStolen{0};
+    LatencyHistogram audioTriggerLatency;
+
+    // Music streaming
+    std::atomic<uint64_t> musicLookaheadSamples{0};
+    std::atomic<uint64_t> musicUnderruns{0};
+    std::atomic<uint64_t> musicUnderrunSamples{0};
+
+    // Simulation: how late each tick ran against its deadline, and how long a turn waited
+    // from its key event to the tick that applied it
+    LatencyHistogram tickJitter;
+    LatencyHistogram inputLatency;
+    std::atomic<uint64_t> droppedTurns{0};
+
+    // Time the autopilot spent choosing each move
+    LatencyHistogram autopilotPlan;
+
+    // Path search: plans made, plans that found no path and left the move to the greedy
+    // bot, and of those the searches that hit their cap
+    std::atomic<uint64_t> pathPlans{0};
+    std::atomic<uint64_t> pathFallbacks{0};
+    std::atomic<uint64_t> pathSearchesCapped{0};
+
+    // Tree search: playouts run and the wall time spent searching
+    std::atomic<uint64_t> searchRollouts{0};
+    std::atomic<uint64_t> searchMicros{0};
+    std::atomic<uint64_t> searchTableHits{0}; // New nodes that started from a table entry
+
+    // Neural bot: positions run through the network and the time spent on them
+    std::atomic<uint64_t> inferences{0};
+    std::atomic<uint64_t> inferenceMicros{0};
+
+    // Presentation while playing
+    std::atomic<uint64_t> framesPresented{0};
+    std::atomic<uint64_t> missedFrameDeadlines{0};
+    LatencyHistogram frameInterval;
+};
+
+extern Metrics metrics;
+
+void reportMetrics(std::ostream& out);
+
+// CPU time used by every thread of this process so far, in seconds
+double processCpuSeconds();
@@ -0,0 +1,175 @@
+#include "musicstream.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <SDL2/SDL_mixer.h>
+#include "audio.h"
+#include "metrics.h"
+
+namespace {
+
+// Single-producer/single-consumer ring of samples with bulk copies in and out
+class PcmRing {
+public:
+    void reset(size_t minimumSamples) {
+        size_t capacity = 1;
+        while (capacity < minimumSamples) capacity <<= 1;
+        samples.assign(capacity, 0);
+        mask = capacity - 1;
+        readIndex.store(0);
+        writeIndex.store(0);
+    }
+
+    size_t capacity() const { return samples.size(); }
+
+    size_t writable() const {
+        return capacity() - (writeIndex.load(std::memory_order_relaxed) - readIndex.load(std::memory_order_acquire));
+    }
+
+    // Producer
+    void write(const Sint16* in, size_t count) {
+        size_t write = writeIndex.load(std::memory_order_relaxed);
+        size_t first = std::min(count, capacity() - (write & mask));
+        memcpy(&samples[write & mask], in, first * sizeof(Sint16));
+        memcpy(&samples[0], in + first, (count - first) * sizeof(Sint16));
+        writeIndex.store(write + count, std::memory_order_release);
+    }
+
+    // Consumer; returns how many samples were available
+    size_t read(Sint16* out, size_t count) {
+        size_t read = readIndex.load(std::memory_order_relaxed);
+        count = std::min(count, writeIndex.load(std::memory_order_acquire) - read);
+        size_t first = std::min(count, capacity() - (read & mask));
+        memcpy(out, &samples[read & mask], first * sizeof(Sint16));
+        memcpy(out + first, &samples[0], (count - first) * sizeof(Sint16));
+        readIndex.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<Sint16> samples;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> readIndex{0};
+    alignas(64) std::atomic<size_t> writeIndex{0};
+};
+
+const size_t stream_chunk_samples = 4096;
+const size_t release_chunk_bytes = 256 * 1024;
+
+PcmRing ring;
+std::thread streamThread;
+std::atomic<bool> stopping{false};
+std::atomic<bool> paused{false};
+std::mutex pauseMutex;
+std::condition_variable resumed;
+bool streaming = false;
+
+const Sint16* track = nullptr;
+size_t trackSamples = 0;
+size_t trackPosition = 0;
+size_t releasedUpTo = 0;
+std::function<void(const void*, size_t)> releaseRange;
+
+// Moves as much of the track into the ring as fits, wrapping at the end
+void fillRing() {
+    size_t space = ring.writable();
+    while (space > 0) {
+        size_t count = std::min(space, trackSamples - trackPosition);
+        ring.write(track + trackPosition, count);
+        trackPosition += count;
+        space -= count;
+
+        if (releaseRange && (trackPosition - releasedUpTo) * sizeof(Sint16) >= release_chunk_bytes) {
+            releaseRange(track + releasedUpTo, (trackPosition - releasedUpTo) * sizeof(Sint16));
+            releasedUpTo = trackPosition;
+        }
+        if (trackPosition == trackSamples) {
+            if (releaseRange) releaseRange(track + releasedUpTo, (trackPosition - releasedUpTo) * sizeof(Sint16));
+            trackPosition = 0;
+            releasedUpTo = 0;
+        }
+    }
+}
+
+void streamLoop(std::chrono::milliseconds idle) {
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (paused.load(std::memory_order_relaxed)) {
+            std::unique_lock<std::mutex> lock(pauseMutex);
+            resumed.wait(lock, [] { return !paused.load() || stopping.load(); });
+            continue;
+        }
+        if (ring.writable() >= stream_chunk_samples) fillRing();
+        std::this_thread::sleep_for(idle);
+    }
+}
+
+void musicHook(void*, Uint8* stream, int len) {
+    // The mixer has already filled the buffer with silence
+    if (paused.load(std::memory_order_relaxed)) return;
+
+    Sint16* out = reinterpret_cast<Sint16*>(stream);
+    size_t wanted = len / sizeof(Sint16);
+    size_t got = ring.read(out, wanted);
+    if (got < wanted) {
+        memset(out + got, 0, (wanted - got) * sizeof(Sint16));
+        metrics.musicUnderruns++;
+        metrics.musicUnderrunSamples += wanted - got;
+    }
+}
+
+} // namespace
+
+bool startMusicStream(const Uint8* pcm, Uint32 bytes, int lookaheadMs, std::function<void(const void*, size_t)> release) {
+    stopMusicStream();
+    if (!audioEnabled() || bytes < sizeof(Sint16)) return false;
+
+    track = reinterpret_cast<const Sint16*>(pcm);
+    trackSamples = bytes / sizeof(Sint16);
+    trackPosition = 0;
+    releasedUpTo = 0;
+    releaseRange = std::move(release);
+
+    // The ring holds the lookahead; it is filled before the hook goes in so playback
+    // starts with a full buffer
+    size_t lookaheadSamples = (size_t)std::max(lookaheadMs, 1) * audio_frequency * audio_channels / 1000;
+    ring.reset(std::max(lookaheadSamples, 2 * stream_chunk_samples));
+    fillRing();
+    metrics.musicLookaheadSamples = (uint64_t)ring.capacity();
+
+    // Wake up often enough that a quarter of the ring is the most that drains between refills
+    auto idle = std::chrono::milliseconds(std::clamp(lookaheadMs / 4, 2, 50));
+    stopping = false;
+    streamThread = std::thread(streamLoop, idle);
+    Mix_HookMusic(musicHook, nullptr);
+    streaming = true;
+    return true;
+}
+
+void stopMusicStream() {
+    if (!streaming) return;
+    Mix_HookMusic(nullptr, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(pauseMutex);
+        stopping = true;
+    }
+    resumed.notify_all();
+    streamThread.join();
+    streaming = false;
+}
+
+bool musicStreaming() {
+    return streaming;
+}
+
+void setMusicStreamPaused(bool pause) {
+    {
+        std::lock_guard<std::mutex> lock(pauseMutex);
+        paused = pause;
+    }
+    resumed.notify_all();
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <SDL2/SDL.h>
+
+const int music_default_lookahead_ms = 500;
+
+// Background music fed from a lock-free PCM ring buffer. A dedicated thread keeps up to
+// lookaheadMs of the track buffered ahead of playback, and the audio callback only ever
+// copies out of the ring, so a slow read never stalls the device.
+//
+// pcm is the whole track, already decoded to the device format, and must stay valid
+// until stopMusicStream(). The track loops. If set, release is called with each range of
+// pcm the streaming thread has finished reading for this loop, every 256 KB. For a baked
+// track mapped from the asset pack that drops its pages again, so what stays resident
+// is the ring plus the stretch of the track being read, whatever the track's length.
+bool startMusicStream(const Uint8* pcm, Uint32 bytes, int lookaheadMs,
+                      std::function<void(const void*, size_t)> release = nullptr);
+void stopMusicStream();
+bool musicStreaming();
+
+// While paused the callback plays silence and the streaming thread sleeps until resumed
+void setMusicStreamPaused(bool paused);
@@ -0,0 +1,256 @@
+#include "network.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <immintrin.h>
+#include "game.h"
+using namespace std;
+
+namespace {
+
+const char magic[4] = {'S', 'N', 'N', '1'};
+const int stride_step = 64;
+const char* names[kernel_count] = {"scalar", "avx2", "avx512-vnni"};
+
+typedef void (*LayerKernel)(const NetworkLayer& layer, const uint8_t* inputs, int batch, int32_t* sums);
+
+void layerScalar(const NetworkLayer& layer, const uint8_t* inputs, int batch, int32_t* sums) {
+    for (int b = 0; b < batch; ++b) {
+        const uint8_t* in = inputs + b * layer.stride;
+        for (int r = 0; r < layer.outputs; ++r) {
+            const int8_t* w = &layer.weights[r * layer.stride];
+            int32_t sum = layer.bias[r];
+            for (int k = 0; k < layer.inputs; ++k) sum += in[k] * w[k];
+            sums[b * layer.outputs + r] = sum;
+        }
+    }
+}
+
+// The SIMD kernels take four inputs per pass so each row of weights is loaded once
+// for all four. Past the end of the batch the extra pointers repeat the first input
+// and their sums are dropped. maddubs multiplies unsigned activations by signed
+// weights into pairs of int16; with both at most 127 a pair can't saturate.
+
+// Sums of four accumulators, a lane each
+__attribute__((target("avx2"))) __m128i sum4(__m256i a, __m256i b, __m256i c, __m256i d) {
+    const __m256i sums = _mm256_hadd_epi32(_mm256_hadd_epi32(a, b), _mm256_hadd_epi32(c, d));
+    return _mm_add_epi32(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+}
+
+// Writes the sums for up to four inputs of the batch, from input b on
+__attribute__((target("avx2"))) void storeSums(const NetworkLayer& layer, int r, int b, int batch, __m128i sums, int32_t* out) {
+    alignas(16) int32_t lanes[4];
+    _mm_store_si128((__m128i*)lanes, sums);
+    for (int j = 0; j < 4 && b + j < batch; ++j) out[(b + j) * layer.outputs + r] = layer.bias[r] + lanes[j];
+}
+
+__attribute__((target("avx2"))) void layerAvx2(const NetworkLayer& layer, const uint8_t* inputs, int batch, int32_t* sums) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    for (int b = 0; b < batch; b += 4) {
+        const uint8_t* in0 = inputs + b * layer.stride;
+        const uint8_t* in1 = b + 1 < batch ? in0 + layer.stride : in0;
+        const uint8_t* in2 = b + 2 < batch ? in0 + 2 * layer.stride : in0;
+        const uint8_t* in3 = b + 3 < batch ? in0 + 3 * layer.stride : in0;
+        for (int r = 0; r < layer.outputs; ++r) {
+            const int8_t* w = &layer.weights[r * layer.stride];
+            __m256i acc0 = _mm256_setzero_si256();
+            __m256i acc1 = _mm256_setzero_si256();
+            __m256i acc2 = _mm256_setzero_si256();
+            __m256i acc3 = _mm256_setzero_si256();
+            for (int k = 0; k < layer.stride; k += 32) {
+                const __m256i weights = _mm256_loadu_si256((const __m256i*)(w + k));
+                acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in0 + k)), weights), ones));
+                acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in1 + k)), weights), ones));
+                acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in2 + k)), weights), ones));
+                acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(_mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(in3 + k)), weights), ones));
+            }
+            storeSums(layer, r, b, batch, sum4(acc0, acc1, acc2, acc3), sums);
+        }
+    }
+}
+
+// GCC 12's AVX-512 headers trip this on the undefined vectors they use internally
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx512f,avx2"))) __m256i fold512(__m512i v) {
+    return _mm256_add_epi32(_mm512_castsi512_si256(v), _mm512_extracti64x4_epi64(v, 1));
+}
+
+// VNNI's dpbusd does the multiply, pairwise add and accumulate in one instruction
+__attribute__((target("avx512f,avx512bw,avx512vnni,avx2"))) void layerAvx512Vnni(const NetworkLayer& layer, const uint8_t* inputs, int batch, int32_t* sums) {
+    for (int b = 0; b < batch; b += 4) {
+        const uint8_t* in0 = inputs + b * layer.stride;
+        const uint8_t* in1 = b + 1 < batch ? in0 + layer.stride : in0;
+        const uint8_t* in2 = b + 2 < batch ? in0 + 2 * layer.stride : in0;
+        const uint8_t* in3 = b + 3 < batch ? in0 + 3 * layer.stride : in0;
+        for (int r = 0; r < layer.outputs; ++r) {
+            const int8_t* w = &layer.weights[r * layer.stride];
+            __m512i acc0 = _mm512_setzero_si512();
+            __m512i acc1 = _mm512_setzero_si512();
+            __m512i acc2 = _mm512_setzero_si512();
+            __m512i acc3 = _mm512_setzero_si512();
+            for (int k = 0; k < layer.stride; k += 64) {
+                const __m512i weights = _mm512_loadu_si512(w + k);
+                acc0 = _mm512_dpbusd_epi32(acc0, _mm512_loadu_si512(in0 + k), weights);
+                acc1 = _mm512_dpbusd_epi32(acc1, _mm512_loadu_si512(in1 + k), weights);
+                acc2 = _mm512_dpbusd_epi32(acc2, _mm512_loadu_si512(in2 + k), weights);
+                acc3 = _mm512_dpbusd_epi32(acc3, _mm512_loadu_si512(in3 + k), weights);
+            }
+            storeSums(layer, r, b, batch, sum4(fold512(acc0), fold512(acc1), fold512(acc2), fold512(acc3)), sums);
+        }
+    }
+}
+
+#pragma GCC diagnostic pop
+
+const LayerKernel kernels[kernel_count] = {layerScalar, layerAvx2, layerAvx512Vnni};
+
+template <typename T>
+void readValues(istream& in, T* values, size_t count) {
+    in.read(reinterpret_cast<char*>(values), sizeof(T) * count);
+}
+
+template <typename T>
+void writeValues(ostream& out, const T* values, size_t count) {
+    out.write(reinterpret_cast<const char*>(values), sizeof(T) * count);
+}
+
+} // namespace
+
+int paddedInputs(int inputs) {
+    return (inputs + stride_step - 1) / stride_step * stride_step;
+}
+
+const char* kernelName(Kernel kernel) {
+    return names[(int)kernel];
+}
+
+bool kernelSupported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return true;
+        case Kernel::Avx2: return __builtin_cpu_supports("avx2");
+        case Kernel::Avx512Vnni: return __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vnni");
+        case Kernel::Count: break;
+    }
+    return false;
+}
+
+Kernel bestKernel() {
+    static const Kernel best = [] {
+        for (int k = kernel_count - 1; k > 0; --k) {
+            if (kernelSupported(Kernel(k))) return Kernel(k);
+        }
+        return Kernel::Scalar;
+    }();
+    return best;
+}
+
+bool Network::load(const string& path) {
+    ifstream file(path, ios::binary);
+    if (!file) {
+        cerr << "Failed to open network " << path << endl;
+        return false;
+    }
+    char header[4] = {};
+    uint32_t count = 0;
+    readValues(file, header, 4);
+    readValues(file, &count, 1);
+    if (!file || memcmp(header, magic, 4) != 0 || count == 0 || count > 64) {
+        cerr << path << ": not a network file" << endl;
+        return false;
+    }
+
+    vector<NetworkLayer> loaded(count);
+    for (uint32_t l = 0; l < count; ++l) {
+        NetworkLayer& layer = loaded[l];
+        uint32_t inputs = 0, outputs = 0;
+        readValues(file, &inputs, 1);
+        readValues(file, &outputs, 1);
+        readValues(file, &layer.multiplier, 1);
+        if (!file || inputs == 0 || outputs == 0 || inputs > 65536 || outputs > 65536 ||
+            (l > 0 && (int)inputs != loaded[l - 1].outputs)) {
+            cerr << path << ": bad shape for layer " << l << endl;
+            return false;
+        }
+        layer.inputs = inputs;
+        layer.outputs = outputs;
+        layer.stride = paddedInputs(inputs);
+        layer.bias.resize(outputs);
+        readValues(file, layer.bias.data(), outputs);
+        layer.weights.assign((size_t)outputs * layer.stride, 0);
+        for (uint32_t r = 0; r < outputs; ++r) readValues(file, &layer.weights[(size_t)r * layer.stride], inputs);
+        // -128 has no positive twin and could saturate the kernels' int16 pairs
+        replace(layer.weights.begin(), layer.weights.end(), (int8_t)-128, (int8_t)-127);
+    }
+    if (!file) {
+        cerr << path << ": file is truncated" << endl;
+        return false;
+    }
+    layers = move(loaded);
+    return true;
+}
+
+bool Network::save(const string& path) const {
+    ofstream file(path, ios::binary | ios::trunc);
+    const uint32_t count = layers.size();
+    writeValues(file, magic, 4);
+    writeValues(file, &count, 1);
+    for (const NetworkLayer& layer : layers) {
+        const uint32_t shape[2] = {(uint32_t)layer.inputs, (uint32_t)layer.outputs};
+        writeValues(file, shape, 2);
+        writeValues(file, &layer.multiplier, 1);
+        writeValues(file, layer.bias.data(), layer.outputs);
+        for (int r = 0; r < layer.outputs; ++r) writeValues(file, &layer.weights[(size_t)r * layer.stride], layer.inputs);
+    }
+    if (!file) {
+        cerr << "Failed to write network " << path << endl;
+        return false;
+    }
+    return true;
+}
+
+void Network::initialize(const vector<int>& sizes, uint64_t seed) {
+    uint64_t state = seed | 1;
+    auto random = [&state] { return xorshift32(state); };
+    layers.assign(sizes.size() - 1, NetworkLayer());
+    for (size_t l = 0; l + 1 < sizes.size(); ++l) {
+        NetworkLayer& layer = layers[l];
+        layer.inputs = sizes[l];
+        layer.outputs = sizes[l + 1];
+        layer.stride = paddedInputs(layer.inputs);
+        // Keeps a hidden layer's outputs in range for inputs spread over 0..127
+        layer.multiplier = 4.0f / (127.0f * sqrt((float)layer.inputs));
+        layer.bias.assign(layer.outputs, 0);
+        layer.weights.assign((size_t)layer.outputs * layer.stride, 0);
+        for (int r = 0; r < layer.outputs; ++r) {
+            for (int k = 0; k < layer.inputs; ++k) layer.weights[(size_t)r * layer.stride + k] = (int8_t)((int)(random() % 255) - 127);
+        }
+    }
+}
+
+void Network::forward(const uint8_t* inputs, int batch, int32_t* outputs, NetworkScratch& scratch, Kernel kernel) const {
+    const LayerKernel run = kernels[(int)kernel];
+    const uint8_t* current = inputs;
+    for (size_t l = 0; l + 1 < layers.size(); ++l) {
+        const NetworkLayer& layer = layers[l];
+        scratch.sums.resize((size_t)batch * layer.outputs);
+        run(layer, current, batch, scratch.sums.data());
+
+        const int nextStride = layers[l + 1].stride;
+        vector<uint8_t>& next = scratch.activations[l % 2];
+        next.assign((size_t)batch * nextStride, 0);
+        for (int b = 0; b < batch; ++b) {
+            const int32_t* sums = &scratch.sums[(size_t)b * layer.outputs];
+            uint8_t* out = &next[(size_t)b * nextStride];
+            for (int r = 0; r < layer.outputs; ++r) {
+                const int scaled = (int)(sums[r] * layer.multiplier + 0.5f);
+                out[r] = sums[r] <= 0 ? 0 : (uint8_t)min(scaled, 127);
+            }
+        }
+        current = next.data();
+    }
+    run(layers.back(), current, batch, outputs);
+}
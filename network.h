@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A small multilayer perceptron run in int8. Activations are uint8 from 0 to 127 and
+// weights int8 from -127 to 127. Each layer sums into int32, adds its bias, and a
+// hidden layer then applies ReLU and scales the sums by its multiplier back into
+// uint8 for the next one. The last layer's int32 sums are the outputs.
+//
+// Weights file, little-endian: "SNN1", the layer count (u32), then per layer its
+// inputs and outputs (u32 each), multiplier (f32), bias (outputs x i32) and weights
+// (outputs rows of inputs x i8). Each layer's inputs are the previous one's outputs.
+struct NetworkLayer {
+    int inputs = 0;
+    int outputs = 0;
+    int stride = 0; // Inputs padded with zero weights to a multiple of 64, the widest kernel step
+    float multiplier = 0.0f;
+    std::vector<int32_t> bias;
+    std::vector<int8_t> weights; // outputs rows of stride
+};
+
+// Dot product kernels, picked at runtime from what the CPU supports
+enum class Kernel {
+    Scalar,
+    Avx2,
+    Avx512Vnni,
+    Count
+};
+const int kernel_count = (int)Kernel::Count;
+
+const char* kernelName(Kernel kernel);
+bool kernelSupported(Kernel kernel);
+Kernel bestKernel();
+
+// Per-thread buffers for forward()
+struct NetworkScratch {
+    std::vector<uint8_t> activations[2];
+    std::vector<int32_t> sums;
+};
+
+class Network {
+public:
+    // Both print what went wrong and return false on failure
+    bool load(const std::string& path);
+    bool save(const std::string& path) const;
+
+    // Random weights for layer sizes {inputs, hidden..., outputs}
+    void initialize(const std::vector<int>& sizes, uint64_t seed);
+
+    int inputs() const { return layers.front().inputs; }
+    int inputStride() const { return layers.front().stride; }
+    int outputs() const { return layers.back().outputs; }
+
+    // Runs a batch of inputs, inputStride() bytes apart with zero padding, and writes
+    // outputs() sums for each. Rows of weights are loaded once per four inputs.
+    void forward(const uint8_t* inputs, int batch, int32_t* outputs, NetworkScratch& scratch,
+                 Kernel kernel = bestKernel()) const;
+
+    std::vector<NetworkLayer> layers;
+};
+
+// Rounds an input count up to a layer's stride
+int paddedInputs(int inputs);
@@ -0,0 +1,101 @@
+#include "pacing.h"
+#include <chrono>
+#include <iostream>
+#include "deadline.h"
+#include "metrics.h"
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+const int vsync_probe_frames = 30;
+
+SDL_Renderer* pacedRenderer = nullptr;
+Pacing pacing = Pacing::Delay;
+Clock::duration framePeriod = chrono::microseconds(1000000 / default_refresh_hz);
+Clock::time_point lastPresent; // Taken straight after the last present
+Clock::time_point frameDue;    // Deadline pacing: when the frame being drawn must be presented
+bool resumed = true;
+int fastPresents = 0;
+
+} // namespace
+
+Pacing setPacing(SDL_Renderer* renderer, Pacing mode, int refreshHz) {
+    pacedRenderer = renderer;
+    framePeriod = chrono::microseconds(1000000 / (refreshHz > 0 ? refreshHz : default_refresh_hz));
+
+    if (mode == Pacing::Vsync) {
+        SDL_RendererInfo info;
+        if (SDL_GetRendererInfo(renderer, &info) != 0 || (info.flags & SDL_RENDERER_SOFTWARE)) {
+            cerr << "Vsync unavailable on this renderer, using deadline pacing" << endl;
+            mode = Pacing::Deadline;
+        } else if (SDL_RenderSetVSync(renderer, 1) != 0) {
+            cerr << "Failed to enable vsync, using deadline pacing: " << SDL_GetError() << endl;
+            mode = Pacing::Deadline;
+        }
+    }
+    if (mode != Pacing::Vsync) SDL_RenderSetVSync(renderer, 0);
+
+    pacing = mode;
+    resetPacing();
+    return mode;
+}
+
+Pacing currentPacing() {
+    return pacing;
+}
+
+void paceFrame() {
+    Clock::time_point now = Clock::now();
+    metrics.framesPresented.fetch_add(1, memory_order_relaxed);
+    if (!resumed) metrics.frameInterval.record(chrono::duration<double, micro>(now - lastPresent).count());
+
+    switch (pacing) {
+        case Pacing::Delay:
+            SDL_Delay(frame_delay);
+            break;
+
+        case Pacing::Vsync:
+            if (!resumed) {
+                Clock::duration interval = now - lastPresent;
+                if (interval > framePeriod * 3 / 2) metrics.missedFrameDeadlines.fetch_add(1, memory_order_relaxed);
+
+                // A present that returns well inside a refresh isn't waiting for vsync
+                fastPresents = interval < framePeriod / 2 ? fastPresents + 1 : 0;
+                if (fastPresents == vsync_probe_frames) {
+                    cerr << "Presents are not blocking on vsync, using deadline pacing" << endl;
+                    setPacing(pacedRenderer, Pacing::Deadline, int(chrono::seconds(1) / framePeriod));
+                    return;
+                }
+            }
+            break;
+
+        case Pacing::Deadline: {
+            // The next frame is drawn once the frame just presented was due, and is due a
+            // period after that
+            Clock::time_point drawAt = resumed ? now + framePeriod : frameDue;
+            if (!resumed && now > frameDue) {
+                // Missed it: count the miss and line up on the next one rather than bursting
+                metrics.missedFrameDeadlines.fetch_add(1, memory_order_relaxed);
+                drawAt = now + framePeriod;
+            }
+            waitUntil(drawAt);
+            frameDue = drawAt + framePeriod;
+            break;
+        }
+
+        case Pacing::Step:
+        case Pacing::Uncapped:
+        case Pacing::Count:
+            break;
+    }
+
+    lastPresent = now;
+    resumed = false;
+}
+
+void resetPacing() {
+    resumed = true;
+    fastPresents = 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include "pacingmode.h"
+
+const int frame_delay = 7;
+const int default_refresh_hz = 60;
+
+// Switches the renderer to the mode and returns the mode actually in effect. Vsync is
+// refused on the software renderer or when the driver won't enable it.
+Pacing setPacing(SDL_Renderer* renderer, Pacing mode, int refreshHz);
+Pacing currentPacing();
+
+// Call straight after each present while playing. Waits as the mode requires, counts
+// frames that missed their deadline, and drops from vsync to deadline pacing if presents
+// turn out not to block after all.
+void paceFrame();
+
+// Call when play resumes, so the time spent in another scene isn't counted as a miss
+void resetPacing();
@@ -0,0 +1,23 @@
+#include "pacingmode.h"
+#include <cstring>
+using namespace std;
+
+namespace {
+
+const char* names[pacing_count] = {"delay", "vsync", "deadline", "step", "uncapped"};
+
+} // namespace
+
+const char* pacingName(Pacing mode) {
+    return names[(int)mode];
+}
+
+bool parsePacing(const char* name, Pacing& result) {
+    for (int i = 0; i < pacing_count; ++i) {
+        if (strcmp(name, names[i]) == 0) {
+            result = Pacing(i);
+            return true;
+        }
+    }
+    return false;
+}
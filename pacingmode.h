@@ -0,0 +1,23 @@
+#pragma once
+
+// How frames are paced, kept apart from pacing.h so config.h can name a mode without
+// pulling in the renderer and metrics.
+//
+// Modes while playing:
+//   delay     sleep frame_delay after every present
+//   vsync     block in a vsynced present (falls back to deadline when unavailable)
+//   deadline  sleep to each frame deadline at the display rate, spinning the last stretch
+//   step      only draw when the simulation has produced a new tick
+//   uncapped  draw as fast as possible, for benchmarks
+enum class Pacing {
+    Delay,
+    Vsync,
+    Deadline,
+    Step,
+    Uncapped,
+    Count
+};
+const int pacing_count = (int)Pacing::Count;
+
+const char* pacingName(Pacing mode);
+bool parsePacing(const char* name, Pacing& result);
@@ -0,0 +1,69 @@
+#include <bits/stdc++.h>
+#include "assetpack.h"
+using namespace std;
+
+// Build-time tool: packs the given files into one page-aligned archive.
+// Usage: packer <output> <file>...
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " <output> <file>..." << endl;
+        return 1;
+    }
+
+    vector<PackEntry> entries;
+    vector<vector<char>> blobs;
+    for (int i = 2; i < argc; ++i) {
+        string name = argv[i];
+        size_t slash = name.find_last_of("/\\");
+        if (slash != string::npos) name = name.substr(slash + 1);
+        if (name.size() >= sizeof(PackEntry::name)) {
+            cerr << "Asset name too long: " << name << endl;
+            return 1;
+        }
+
+        ifstream in(argv[i], ios::binary);
+        if (!in) {
+            cerr << "Failed to open " << argv[i] << endl;
+            return 1;
+        }
+        blobs.emplace_back(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+
+        PackEntry entry{};
+        memcpy(entry.name, name.c_str(), name.size());
+        entry.size = blobs.back().size();
+        entries.push_back(entry);
+    }
+
+    // Lay the blobs out after the table of contents, each on its own page
+    auto align = [](uint64_t offset) { return (offset + pack_alignment - 1) / pack_alignment * pack_alignment; };
+    uint64_t offset = align(sizeof(PackHeader) + entries.size() * sizeof(PackEntry));
+    for (auto& entry : entries) {
+        entry.offset = offset;
+        offset = align(offset + entry.size);
+    }
+
+    PackHeader header{};
+    memcpy(header.magic, pack_magic, sizeof(pack_magic));
+    header.version = pack_version;
+    header.count = (uint32_t)entries.size();
+
+    ofstream out(argv[1], ios::binary | ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(PackEntry));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        out.seekp(entries[i].offset);
+        out.write(blobs[i].data(), blobs[i].size());
+    }
+    // Pad the last blob out to a full page so the file size is aligned too
+    if (out.tellp() < (streamoff)offset) {
+        out.seekp(offset - 1);
+        out.put(0);
+    }
+    if (!out) {
+        cerr << "Failed to write " << argv[1] << endl;
+        return 1;
+    }
+
+    cout << "Packed " << entries.size() << " assets into " << argv[1] << " (" << offset << " bytes)" << endl;
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include "pathfinder.h"
+#include <algorithm>
+#include "config.h"
+#include "metrics.h"
+using namespace std;
+
+void PathFinder::resize(int cells) {
+    reached.assign(cells, 0);
+    occupied.assign(cells, 0);
+    freeAt.assign(cells, 0);
+    depth.assign(cells, 0);
+    arrivedBy.assign(cells, 0);
+    expanded.assign(cells, 0);
+    // Paths are at most one move per cell, and so are estimates
+    open.resize(2 * cells + 1);
+    for (vector<int>& bucket : open) bucket.reserve(8);
+    highest = 0;
+    route.reserve(cells);
+    generation = 0;
+}
+
+void PathFinder::clear() {
+    route.clear();
+    routeStep = 0;
+}
+
+SDL_Keycode PathFinder::plan(const GameState& game) {
+    const Config& board = config();
+    const int width = board.gridWidth;
+    const int height = board.gridHeight;
+    if ((int)reached.size() != width * height) {
+        resize(width * height);
+        clear();
+    }
+
+    // No food on the board is -1, which no cell matches
+    const int food = game.food.x >= 0 ? game.food.y * width + game.food.x : -1;
+    const int bonus = game.bonusFoodActive ? game.bonusFood.y * width + game.bonusFood.x : -1;
+    foodDistance.update(game);
+
+    const SnakeSegment head = game.snake.front();
+    const int start = head.y * width + head.x;
+    const int* neighbours = neighbourCells().data();
+    metrics.pathPlans.fetch_add(1, memory_order_relaxed);
+
+    // A tick later every body cell frees a move sooner and the rest of the path is a move
+    // shorter, so it's still safe and still shortest while the snake keeps to it and the
+    // food stays where it was
+    if (routeStep < route.size() && game.ticks == routeTick && start == routeHead && food == routeFood &&
+        bonus == routeBonus) {
+        lastLength = (int)(route.size() - routeStep);
+        const int m = route[routeStep++];
+        routeHead = neighbours[start * 4 + m];
+        ++routeTick;
+        return move_directions[m];
+    }
+    clear();
+
+    if (++generation == 0) {
+        // Wrapped after four billion plans; start the stamps again from a clean slate
+        resize(width * height);
+        generation = 1;
+    }
+
+    // update() checks the new head against every segment but the head before the tail
+    // moves, so segment i blocks its cell until move len - i + 1
+    const int length = (int)game.snake.size();
+    for (int i = 1; i < length; ++i) {
+        int cell = game.snake[i].y * width + game.snake[i].x;
+        occupied[cell] = generation;
+        freeAt[cell] = (uint16_t)(length - i + 1);
+    }
+
+    lastLength = 0;
+    if (foodDistance.estimate(start) == DistanceField::unreachable) {
+        metrics.pathFallbacks.fetch_add(1, memory_order_relaxed);
+        return 0;
+    }
+    reached[start] = generation;
+    depth[start] = 0;
+    for (int b = 0; b <= highest; ++b) open[b].clear();
+    int lowest = foodDistance.estimate(start);
+    highest = lowest;
+    open[lowest].push_back(start);
+
+    // Capped at as many cells as the snake could ever enter: the free ones and its own
+    const int maxExpansions = (int)(game.freeCells.size() + game.snake.size());
+    const SDL_Keycode reverse = oppositeDirection(game.direction);
+    int expansions = 0;
+    while (expansions < maxExpansions) {
+        while (lowest <= highest && open[lowest].empty()) ++lowest;
+        if (lowest > highest) break;
+        // The cell found last goes first, which among equal estimates is the one furthest
+        // along the path being followed
+        const int cell = open[lowest].back();
+        open[lowest].pop_back();
+        // Left behind when the cell was found again by a shorter path; the estimate never
+        // drops by more than a move a cell, so a cell's first expansion is its shortest
+        if (expanded[cell] == generation) continue;
+        expanded[cell] = generation;
+        ++expansions;
+
+        if (cell != start && (cell == food || cell == bonus)) {
+            // Walk back to the head; a move and its opposite differ in the lowest bit
+            for (int at = cell; at != start; at = neighbours[at * 4 + (arrivedBy[at] ^ 1)]) {
+                route.push_back(arrivedBy[at]);
+            }
+            std::reverse(route.begin(), route.end());
+            lastLength = (int)route.size();
+            routeStep = 1;
+            routeHead = neighbours[start * 4 + route[0]];
+            routeTick = game.ticks + 1;
+            routeFood = food;
+            routeBonus = bonus;
+            return move_directions[route[0]];
+        }
+
+        const int nextDepth = depth[cell] + 1;
+        for (int m = 0; m < 4; ++m) {
+            if (cell == start && move_directions[m] == reverse) continue;
+            const int next = neighbours[cell * 4 + m];
+            if (expanded[next] == generation) continue;
+            const uint16_t estimate = foodDistance.estimate(next);
+            if (estimate == DistanceField::unreachable) continue;
+            if (occupied[next] == generation && nextDepth < freeAt[next]) continue;
+            if (reached[next] == generation && depth[next] <= nextDepth) continue;
+
+            reached[next] = generation;
+            depth[next] = (uint16_t)nextDepth;
+            arrivedBy[next] = (uint8_t)m;
+            const int pathLength = nextDepth + estimate;
+            open[pathLength].push_back(next);
+            lowest = min(lowest, pathLength);
+            highest = max(highest, pathLength);
+        }
+    }
+
+    metrics.pathFallbacks.fetch_add(1, memory_order_relaxed);
+    if (expansions == maxExpansions) metrics.pathSearchesCapped.fetch_add(1, memory_order_relaxed);
+    return 0;
+}
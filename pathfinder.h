@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "distancefield.h"
+#include "game.h"
+
+// A* over the wrapped board from the snake's head to the nearest food. A body cell
+// counts as free from the move on which the tail will have left it, so paths can follow
+// the snake's own tail. The estimate is the food's distance field, exact but for the
+// body, so the search goes straight around obstacles and skips cells cut off from
+// food. Ties go to the cell furthest along, so with nothing in the way the search only
+// takes the cells of one path, and it never takes more cells than the board has room
+// for. The path it finds is followed from then on, without searching again, until
+// the snake leaves it or the food moves. Moves it finds no path for are left to the
+// greedy bot and counted in metrics. All buffers are sized once for the board and
+// then reused: cells are stamped with the search generation instead of being cleared,
+// so planning a move allocates nothing.
+class PathFinder {
+public:
+    // First move of a shortest safe path to food or bonus food, or 0 if there is none
+    SDL_Keycode plan(const GameState& game);
+
+    // Moves in the path the last plan() followed, from where the head was
+    int pathLength() const { return lastLength; }
+
+    // Forgets the path being followed, for a fresh game
+    void clear();
+
+private:
+    void resize(int cells);
+
+    uint32_t generation = 0;
+    std::vector<uint32_t> reached;  // Generation in which the cell was reached
+    std::vector<uint32_t> occupied; // Generation in which freeAt was set for the cell
+    std::vector<uint16_t> freeAt;   // First move on which a body cell may be entered
+    std::vector<uint16_t> depth;    // Moves from the head
+    std::vector<uint8_t> arrivedBy; // Index of the move that reached the cell
+    std::vector<uint32_t> expanded; // Generation in which the cell's neighbours were tried
+    std::vector<std::vector<int>> open; // Cells by estimated path length
+    int highest = 0;                // Longest estimate in open
+    DistanceField foodDistance;
+    int lastLength = 0;
+
+    // The path being followed, as move indices, and what it was found for: the next
+    // move's tick and head cell, and the food and bonus cells
+    std::vector<uint8_t> route;
+    size_t routeStep = 0;
+    uint64_t routeTick = 0;
+    int routeHead = -1;
+    int routeFood = -1;
+    int routeBonus = -1;
+};
@@ -0,0 +1,216 @@
+#include "policy.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "config.h"
+#include "metrics.h"
+#include "threadpool.h"
+using namespace std;
+
+namespace {
+
+const int bench_hidden = 64;
+const int bench_batch_sizes[] = {1, 4, 16, 64, 256};
+const int bench_inferences = 1 << 20; // Per batch size and thread count
+
+struct Heading {
+    int x, y;
+};
+
+Heading headingOf(SDL_Keycode direction) {
+    const int m = moveIndex(direction);
+    return {move_dx[m], move_dy[m]};
+}
+
+SDL_Keycode directionOf(Heading heading) {
+    for (int m = 0; m < 4; ++m) {
+        if (move_dx[m] == heading.x && move_dy[m] == heading.y) return move_directions[m];
+    }
+    return 0;
+}
+
+// Facing f on a board whose y grows downwards, right is f turned clockwise
+Heading rightOf(Heading forward) {
+    return {-forward.y, forward.x};
+}
+
+SDL_Keycode actionDirection(SDL_Keycode direction, int action) {
+    const Heading forward = headingOf(direction);
+    const Heading right = rightOf(forward);
+    if (action == 0) return directionOf({-right.x, -right.y});
+    return directionOf(action == 1 ? forward : right);
+}
+
+double secondsSince(Uint64 start) {
+    return (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+} // namespace
+
+void observe(const GameState& game, uint8_t* observation) {
+    const Config& settings = config();
+    const SnakeSegment head = game.snake.front();
+    const Heading forward = headingOf(game.direction);
+    const Heading right = rightOf(forward);
+
+    uint8_t* danger = observation;
+    uint8_t* food = observation + view_size * view_size;
+    for (int row = 0; row < view_size; ++row) {
+        const int ahead = view_radius - row;
+        for (int column = 0; column < view_size; ++column) {
+            const int side = column - view_radius;
+            const SnakeSegment at = wrapCell(head.x + forward.x * ahead + right.x * side,
+                                             head.y + forward.y * ahead + right.y * side);
+            const int cell = row * view_size + column;
+            danger[cell] = checkCollision(game, at.x, at.y) ? 127 : 0;
+            food[cell] = (game.food.x == at.x && game.food.y == at.y) ||
+                         (game.bonusFoodActive && game.bonusFood.x == at.x && game.bonusFood.y == at.y) ? 127 : 0;
+        }
+    }
+
+    uint8_t* bearing = food + view_size * view_size;
+    fill(bearing, bearing + 4, 0);
+    SDL_Point target = game.food;
+    int dx = wrappedDelta(head.x, target.x, settings.gridWidth);
+    int dy = wrappedDelta(head.y, target.y, settings.gridHeight);
+    if (game.bonusFoodActive) {
+        const int bx = wrappedDelta(head.x, game.bonusFood.x, settings.gridWidth);
+        const int by = wrappedDelta(head.y, game.bonusFood.y, settings.gridHeight);
+        if (target.x < 0 || abs(bx) + abs(by) < abs(dx) + abs(dy)) {
+            target = game.bonusFood;
+            dx = bx;
+            dy = by;
+        }
+    }
+    if (target.x < 0) return;
+    const int along = dx * forward.x + dy * forward.y;
+    const int across = dx * right.x + dy * right.y;
+    bearing[0] = along > 0 ? 127 : 0;
+    bearing[1] = along < 0 ? 127 : 0;
+    bearing[2] = across < 0 ? 127 : 0;
+    bearing[3] = across > 0 ? 127 : 0;
+}
+
+const Network* policyNetwork() {
+    static const Network* network = [] () -> const Network* {
+        static Network loaded;
+        const string& path = config().policy;
+        if (!loaded.load(path)) return nullptr;
+        if (loaded.inputs() != observation_size || loaded.outputs() != policy_actions) {
+            cerr << path << ": the policy needs " << observation_size << " inputs and " << policy_actions << " outputs, not "
+                 << loaded.inputs() << " and " << loaded.outputs() << endl;
+            return nullptr;
+        }
+        return &loaded;
+    }();
+    return network;
+}
+
+SDL_Keycode NeuralPolicy::move(const GameState& game) {
+    const GameState* games[1] = {&game};
+    SDL_Keycode direction = 0;
+    moves(games, 1, &direction);
+    return direction;
+}
+
+void NeuralPolicy::moves(const GameState* const* games, int count, SDL_Keycode* directions) {
+    const Network* playing = network ? network : policyNetwork();
+    if (!playing) {
+        fill(directions, directions + count, 0);
+        return;
+    }
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const int stride = playing->inputStride();
+    observations.assign((size_t)count * stride, 0);
+    for (int i = 0; i < count; ++i) observe(*games[i], &observations[(size_t)i * stride]);
+    outputs.resize((size_t)count * policy_actions);
+    playing->forward(observations.data(), count, outputs.data(), scratch);
+
+    for (int i = 0; i < count; ++i) {
+        const GameState& game = *games[i];
+        const int32_t* scores = &outputs[(size_t)i * policy_actions];
+        directions[i] = game.direction;
+        int32_t best = 0;
+        bool found = false;
+        for (int action = 0; action < policy_actions; ++action) {
+            const SDL_Keycode direction = actionDirection(game.direction, action);
+            const SnakeSegment next = step(game.snake.front(), direction);
+            if (checkCollision(game, next.x, next.y) || (found && scores[action] <= best)) continue;
+            directions[i] = direction;
+            best = scores[action];
+            found = true;
+        }
+    }
+    metrics.inferences.fetch_add(count, memory_order_relaxed);
+    metrics.inferenceMicros.fetch_add((SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency(),
+                                      memory_order_relaxed);
+}
+
+int runNetworkBench() {
+    Network network;
+    network.initialize({observation_size, bench_hidden, bench_hidden, policy_actions}, 1);
+    const int stride = network.inputStride();
+    const int largest = bench_batch_sizes[sizeof(bench_batch_sizes) / sizeof(bench_batch_sizes[0]) - 1];
+
+    // Inputs like the real ones: mostly empty, some cells set
+    vector<uint8_t> inputs((size_t)largest * stride, 0);
+    uint32_t state = 12345;
+    for (int b = 0; b < largest; ++b) {
+        for (int k = 0; k < observation_size; ++k) {
+            state = state * 1664525u + 1013904223u;
+            inputs[(size_t)b * stride + k] = (state >> 24) < 48 ? 127 : 0;
+        }
+    }
+
+    NetworkScratch scratch;
+    vector<int32_t> expected((size_t)largest * policy_actions);
+    vector<int32_t> outputs(expected.size());
+    bool failed = false;
+    cout << "Network " << observation_size << "-" << bench_hidden << "-" << bench_hidden << "-" << policy_actions
+         << ", kernel " << kernelName(bestKernel()) << endl;
+    for (int k = 0; k < kernel_count; ++k) {
+        if (!kernelSupported(Kernel(k))) {
+            cout << "  " << kernelName(Kernel(k)) << ": not supported" << endl;
+            continue;
+        }
+        // Every batch size, so the kernels' partial groups of four are covered too
+        bool matched = true;
+        for (int batch : bench_batch_sizes) {
+            for (int size = batch; size <= batch + 3 && size <= largest; ++size) {
+                network.forward(inputs.data(), size, expected.data(), scratch, Kernel::Scalar);
+                network.forward(inputs.data(), size, outputs.data(), scratch, Kernel(k));
+                matched &= equal(expected.begin(), expected.begin() + size * policy_actions, outputs.begin());
+            }
+        }
+        cout << "  " << kernelName(Kernel(k)) << ": " << (matched ? "matches scalar" : "MISMATCH") << endl;
+        failed |= !matched;
+    }
+
+    const unsigned threads = max(1u, thread::hardware_concurrency());
+    cout << fixed << setprecision(0);
+    for (unsigned workers : {1u, threads}) {
+        ThreadPool pool(workers);
+        for (int batch : bench_batch_sizes) {
+            const Uint64 start = SDL_GetPerformanceCounter();
+            for (unsigned w = 0; w < workers; ++w) {
+                pool.submit([&network, &inputs, batch] {
+                    NetworkScratch local;
+                    vector<int32_t> results((size_t)batch * policy_actions);
+                    for (int done = 0; done < bench_inferences; done += batch) {
+                        network.forward(inputs.data(), batch, results.data(), local);
+                    }
+                });
+            }
+            pool.wait();
+            const double seconds = secondsSince(start);
+            cout << "  " << workers << (workers == 1 ? " thread" : " threads") << ", batch " << setw(3) << batch << ": "
+                 << setw(10) << bench_inferences * (double)workers / seconds << " inferences/s" << endl;
+        }
+        if (threads == 1) break;
+    }
+    cout << "Network bench " << (failed ? "FAILED" : "ok") << endl;
+    return failed ? 1 : 0;
+}
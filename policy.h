@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "game.h"
+#include "network.h"
+
+// What the neural bot sees: the 11 x 11 cells around the head, turned so the snake
+// always faces up, as one plane of danger (body and obstacles) and one of food (food
+// and bonus food), then four flags for whether the nearest food lies ahead, behind, to
+// the left or to the right. Every value is 0 or 127. Seeing the board from the
+// snake's point of view means a network learns one way to turn, not four.
+const int view_radius = 5;
+const int view_size = 2 * view_radius + 1;
+const int observation_size = 2 * view_size * view_size + 4;
+
+// The network's outputs score turning left, going straight on and turning right
+const int policy_actions = 3;
+
+// Writes observation_size values; the padding up to the network's stride is left alone
+void observe(const GameState& game, uint8_t* observation);
+
+// The network in config().policy, loaded on first use and shared read-only by every
+// thread. Null when it can't be loaded or has the wrong shape, which is printed once.
+const Network* policyNetwork();
+
+// Plays moves with a policy network: the highest scoring action whose next cell is
+// free, or straight on when none is. Keeps its buffers between calls, so use one per
+// thread. Several games can be run through the network as one batch, which loads
+// each row of weights once for four games instead of once per game. Inferences and
+// their time go to metrics.
+class NeuralPolicy {
+public:
+    // Plays with network, or with policyNetwork() when it's null
+    explicit NeuralPolicy(const Network* network = nullptr) : network(network) {}
+
+    // Next heading, or 0 with no network to play with
+    SDL_Keycode move(const GameState& game);
+    void moves(const GameState* const* games, int count, SDL_Keycode* directions);
+
+private:
+    const Network* network;
+    NetworkScratch scratch;
+    std::vector<uint8_t> observations;
+    std::vector<int32_t> outputs;
+};
+
+// --nn-bench: checks each dot product kernel the CPU has against the scalar one on a
+// random network of the policy's shape, then measures inferences per second at a
+// range of batch sizes, on one thread and on all of them. Returns the exit code.
+int runNetworkBench();
@@ -0,0 +1,183 @@
+#include "simulation.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "bot.h"
+#include "config.h"
+#include "deadline.h"
+#include "metrics.h"
+#include "spscqueue.h"
+#include "triplebuffer.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const int turn_buffer_size = 4;
+
+struct CommandMessage {
+    SimCommand command;
+    Uint32 timestamp;
+};
+
+struct PendingTurn {
+    SDL_Keycode direction;
+    Uint32 timestamp;
+};
+
+SpscQueue<CommandMessage, 64> commands;
+TripleBuffer<GameSnapshot> snapshots;
+std::thread simThread;
+std::mutex wakeMutex;
+std::condition_variable wake;
+std::atomic<bool> stopping{false};
+bool started = false;
+
+// Owned by the simulation thread once it is running
+GameState state;
+uint32_t game = 0;
+uint32_t turnsApplied = 0;
+bool ticking = false;
+bool autopilotOn = false;
+std::unique_ptr<Autopilot> autopilot;
+Clock::duration tickLength;
+Clock::time_point nextTick;
+
+// Turns waiting for a tick, oldest first
+PendingTurn pendingTurns[turn_buffer_size];
+int pendingHead = 0;
+int pendingCount = 0;
+
+// Each turn is checked against the one before it, so two quick turns (e.g. up then left
+// while heading right) both go through, while a reversal can't sneak in between ticks
+void queueTurn(SDL_Keycode direction, Uint32 timestamp) {
+    if (autopilotOn) return;
+    SDL_Keycode last = pendingCount ? pendingTurns[(pendingHead + pendingCount - 1) % turn_buffer_size].direction : state.direction;
+    if (direction == last || direction == oppositeDirection(last)) return;
+    if (pendingCount == turn_buffer_size) {
+        metrics.droppedTurns.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    pendingTurns[(pendingHead + pendingCount) % turn_buffer_size] = {direction, timestamp};
+    ++pendingCount;
+}
+
+void applyNextTurn() {
+    if (pendingCount == 0) return;
+    PendingTurn pending = pendingTurns[pendingHead];
+    pendingHead = (pendingHead + 1) % turn_buffer_size;
+    --pendingCount;
+    if (!turn(state, pending.direction)) return;
+    ++turnsApplied;
+    if (pending.timestamp) metrics.inputLatency.record((SDL_GetTicks() - pending.timestamp) * 1000.0);
+}
+
+// A configured seed makes every game repeatable; otherwise each one is different
+uint64_t gameSeed() {
+    return config().seed ? config().seed + game : SDL_GetPerformanceCounter();
+}
+
+void publish() {
+    GameSnapshot& snapshot = snapshots.back();
+    snapshot.state = state; // Reuses the slot's capacity, so steady state doesn't allocate
+    snapshot.game = game;
+    snapshot.tickCounter = SDL_GetPerformanceCounter();
+    snapshot.turnsApplied = turnsApplied;
+    snapshot.autopilot = autopilotOn;
+    snapshots.publish();
+}
+
+void applyCommands() {
+    CommandMessage message;
+    while (commands.pop(message)) {
+        switch (message.command) {
+            case SimCommand::TurnUp: queueTurn(SDLK_UP, message.timestamp); break;
+            case SimCommand::TurnDown: queueTurn(SDLK_DOWN, message.timestamp); break;
+            case SimCommand::TurnLeft: queueTurn(SDLK_LEFT, message.timestamp); break;
+            case SimCommand::TurnRight: queueTurn(SDLK_RIGHT, message.timestamp); break;
+            case SimCommand::Reset:
+                resetGame(state, gameSeed());
+                ++game;
+                ticking = false;
+                pendingCount = 0;
+                publish();
+                break;
+            case SimCommand::Pause: ticking = false; break;
+            case SimCommand::ToggleAutopilot:
+                autopilotOn = !autopilotOn;
+                pendingCount = 0;
+                publish();
+                break;
+            case SimCommand::Resume:
+                // Coming back must not replay the time spent paused
+                if (!ticking) nextTick = Clock::now() + tickLength;
+                ticking = true;
+                break;
+        }
+    }
+}
+
+void simulationLoop() {
+    while (!stopping.load(std::memory_order_relaxed)) {
+        applyCommands();
+        if (!ticking || !state.alive) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [] { return !commands.empty() || stopping.load(); });
+            continue;
+        }
+
+        waitUntil(nextTick);
+        applyCommands();
+        if (!ticking || stopping.load(std::memory_order_relaxed)) continue;
+
+        Clock::time_point now = Clock::now();
+        metrics.tickJitter.record(std::chrono::duration<double, std::micro>(now - nextTick).count());
+        if (autopilotOn) turn(state, autopilot->move(state));
+        else applyNextTurn();
+        update(state);
+        publish();
+
+        nextTick += tickLength;
+        if (now - nextTick > 5 * tickLength) nextTick = now; // Don't try to catch up after a stall
+    }
+}
+
+} // namespace
+
+void startSimulation() {
+    if (started) return;
+    tickLength = std::chrono::milliseconds(config().tickMs);
+    autopilot.reset(new Autopilot(config().bot));
+    autopilotOn = config().autopilot;
+    resetGame(state, gameSeed());
+    publish();
+    stopping = false;
+    simThread = std::thread(simulationLoop);
+    started = true;
+}
+
+void stopSimulation() {
+    if (!started) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    simThread.join();
+    started = false;
+}
+
+void sendCommand(SimCommand command, Uint32 timestamp) {
+    commands.push({command, timestamp});
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+}
+
+const GameSnapshot& latestSnapshot() {
+    return snapshots.read();
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <SDL2/SDL.h>
+#include "game.h"
+
+// What the simulation publishes after every change to the game
+struct GameSnapshot {
+    GameState state;
+    uint32_t game = 0;      // Counts resets, so a snapshot can be matched to its game
+    Uint64 tickCounter = 0; // SDL performance counter when the state was produced
+    uint32_t turnsApplied = 0;
+    bool autopilot = false;
+};
+
+enum class SimCommand : Uint8 {
+    TurnUp,
+    TurnDown,
+    TurnLeft,
+    TurnRight,
+    Reset,
+    Pause,
+    Resume,
+    ToggleAutopilot
+};
+
+// Runs the game on its own thread, ticking every config().tickMs while resumed and sleeping
+// otherwise. Commands go in through a wait-free queue and the state comes back out
+// through a triple buffer, so a slow frame or a present stalled on vsync never holds
+// up a tick. Sounds are posted straight from the simulation thread.
+void startSimulation();
+void stopSimulation();
+
+// Main thread only. Turns are buffered and applied one per tick in the order they were
+// pressed; timestamp is the key event's SDL_GetTicks() time, used for latency metrics.
+void sendCommand(SimCommand command, Uint32 timestamp = 0);
+const GameSnapshot& latestSnapshot();
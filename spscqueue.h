@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer/single-consumer ring buffer. push() and pop() are wait-free:
+// each side only ever writes its own index and reads the other's, so one thread may
+// push while another pops without locks. Capacity must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side. Returns false (dropping the item) when the queue is full.
+    bool push(const T& item) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - cachedHead == Capacity) {
+            cachedHead = headIndex.load(std::memory_order_acquire);
+            if (tail - cachedHead == Capacity) return false;
+        }
+        items[tail & (Capacity - 1)] = item;
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(T& item) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        if (head == cachedTail) {
+            cachedTail = tailIndex.load(std::memory_order_acquire);
+            if (head == cachedTail) return false;
+        }
+        item = items[head & (Capacity - 1)];
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate from either side; exact only when the other side is idle
+    bool empty() const {
+        return headIndex.load(std::memory_order_acquire) == tailIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    // Producer and consumer state on separate cache lines so they don't false-share
+    alignas(64) std::atomic<size_t> tailIndex{0};
+    size_t cachedHead = 0;
+    alignas(64) std::atomic<size_t> headIndex{0};
+    size_t cachedTail = 0;
+    alignas(64) T items[Capacity];
+};
@@ -5,24 +5,18 @@
 #include <SDL2/SDL_mixer.h>
 #include <vector>
 #include <cstdlib>
+#include "config.h"
 
 using namespace std;
 
 // Constants
-const int screen_width = 700;
-const int screen_height = 500;
-const int block_size = 20;
+const int idle_wait_ms = 250;
 
 // Structures
 struct SnakeSegment {
     int x, y;
 };
 
-// Obstacles
-SDL_Rect obstacle1{100, 120, 200, 20};
-SDL_Rect obstacle2{420, 360, 200, 20};
-SDL_Rect obstacle3{300, 240, 100, 20};
-
 // SDL Variables
 SDL_Window* window = nullptr;
 SDL_Renderer* renderer = nullptr;
@@ -40,29 +34,42 @@ int score = 0;
 SDL_Rect scoreRect = {30, 30, 0, 0};
 bool running = true;
 
+// Scenes. Playing ticks every config().tickMs; the prompts wait for input without spinning.
+enum class Scene {
+    Playing,
+    ObstaclePrompt,
+    GameOver
+};
+Scene scene = Scene::Playing;
+bool obstacleForgiven = false;
+
 // Function prototypes
 void render(const vector<SnakeSegment>& snake, const SDL_Point& food, const SDL_Point& bonusFood);
 void update(vector<SnakeSegment>& snake, SDL_Point& food, SDL_Point& bonusFood, SDL_Keycode& direction, bool& bonusFoodActive);
 bool checkCollision(const vector<SnakeSegment>& snake, int x, int y);
-bool handleObstacleCollision();
+void renderObstaclePrompt();
 void spawnBonusFood(SDL_Point& bonusFood, const vector<SnakeSegment>& snake, const SDL_Point& food);
 void updateScoreTexture();
-void displayGameOver();
+void renderGameOver();
 void cleanup();
 
 int main(int argc, char* argv[]) {
+    if (!loadConfig(argc, argv)) return 1;
+    const bool useAudio = config().audio;
+    const int audioBuffer = config().audioBuffer > 0 ? config().audioBuffer : 2048;
+
     // Initialize SDL, SDL_ttf, and SDL_mixer
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0 || TTF_Init() != 0 || Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
+    if (SDL_Init(SDL_INIT_VIDEO | (useAudio ? SDL_INIT_AUDIO : 0)) != 0 || TTF_Init() != 0 || (useAudio && Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, audioBuffer) < 0)) {
         cerr << "Initialization failed: " << SDL_GetError() << endl;
         return 1;
     }
 
     // Create window and renderer
-    window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, screen_width, screen_height, SDL_WINDOW_SHOWN);
+    window = SDL_CreateWindow("Snake Game", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, config().screenWidth, config().screenHeight, SDL_WINDOW_SHOWN);
     renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
     // Load font
-    font = TTF_OpenFont("arial.ttf", 24);
+    font = TTF_OpenFont(config().font.c_str(), 24);
     if (!font) {
         cerr << "Failed to load font: " << TTF_GetError() << endl;
         cleanup();
@@ -70,7 +77,7 @@ int main(int argc, char* argv[]) {
     }
 
     // Load background image
-    SDL_Surface* backgroundSurface = SDL_LoadBMP("47412.bmp");
+    SDL_Surface* backgroundSurface = SDL_LoadBMP(config().background.c_str());
     if (!backgroundSurface) {
         cerr << "Failed to load background image: " << SDL_GetError() << endl;
         cleanup();
@@ -79,22 +86,22 @@ int main(int argc, char* argv[]) {
     backgroundTexture = SDL_CreateTextureFromSurface(renderer, backgroundSurface);
     SDL_FreeSurface(backgroundSurface);
 
-    // Load audio
-    bgMusic = Mix_LoadMUS("audio.mp3");
-    eatSound = Mix_LoadWAV("eating-sound-effect-36186.mp3");
-    gameOverSound = Mix_LoadWAV("game-over-arcade-6435.mp3");
-    if (!bgMusic || !eatSound || !gameOverSound) {
-        cerr << "Failed to load audio: " << Mix_GetError() << endl;
-        cleanup();
-        return 1;
+    // Load audio and play background music
+    if (useAudio) {
+        bgMusic = Mix_LoadMUS(config().music.c_str());
+        eatSound = Mix_LoadWAV(config().eatSound.c_str());
+        gameOverSound = Mix_LoadWAV(config().gameOverSound.c_str());
+        if (!bgMusic || !eatSound || !gameOverSound) {
+            cerr << "Failed to load audio: " << Mix_GetError() << endl;
+            cleanup();
+            return 1;
+        }
+        Mix_PlayMusic(bgMusic, -1);
     }
 
-    // Play background music
-    Mix_PlayMusic(bgMusic, -1);
-
     // Initialize game objects
-    vector<SnakeSegment> snake{{15, 15}};
-    SDL_Point food = {10, 10};
+    vector<SnakeSegment> snake{{min(15, config().gridWidth - 1), min(15, config().gridHeight - 1)}};
+    SDL_Point food = {min(10, config().gridWidth - 1), min(10, config().gridHeight - 1)};
     SDL_Point bonusFood = {-1, -1};
     SDL_Keycode direction = SDLK_RIGHT;
     bool bonusFoodActive = false;
@@ -105,18 +112,35 @@ int main(int argc, char* argv[]) {
     // Main game loop
     while (running) {
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        bool haveEvent = scene == Scene::Playing ? SDL_PollEvent(&event) : SDL_WaitEventTimeout(&event, idle_wait_ms);
+        for (; haveEvent; haveEvent = SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = false;
             } else if (event.type == SDL_KEYDOWN) {
-                switch (event.key.keysym.sym) {
-                    case SDLK_UP: if (direction != SDLK_DOWN) direction = SDLK_UP; break;
-                    case SDLK_DOWN: if (direction != SDLK_UP) direction = SDLK_DOWN; break;
-                    case SDLK_LEFT: if (direction != SDLK_RIGHT) direction = SDLK_LEFT; break;
-                    case SDLK_RIGHT: if (direction != SDLK_LEFT) direction = SDLK_RIGHT; break;
+                SDL_Keycode key = event.key.keysym.sym;
+                if (scene == Scene::Playing) {
+                    switch (key) {
+                        case SDLK_UP: if (direction != SDLK_DOWN) direction = SDLK_UP; break;
+                        case SDLK_DOWN: if (direction != SDLK_UP) direction = SDLK_DOWN; break;
+                        case SDLK_LEFT: if (direction != SDLK_RIGHT) direction = SDLK_LEFT; break;
+                        case SDLK_RIGHT: if (direction != SDLK_LEFT) direction = SDLK_RIGHT; break;
+                    }
+                } else if (scene == Scene::ObstaclePrompt) {
+                    if (key == SDLK_y) {
+                        score -= 10;
+                        updateScoreTexture();
+                        obstacleForgiven = true;
+                        scene = Scene::Playing;
+                    } else if (key == SDLK_n) {
+                        running = false;
+                    }
+                } else {
+                    running = false;
                 }
             }
         }
+        if (!running) break;
+        if (scene != Scene::Playing) continue;
 
         update(snake, food, bonusFood, direction, bonusFoodActive);
 
@@ -125,9 +149,11 @@ int main(int argc, char* argv[]) {
         SDL_RenderCopy(renderer, backgroundTexture, nullptr, nullptr);
         render(snake, food, bonusFood);
         SDL_RenderCopy(renderer, scoreTexture, nullptr, &scoreRect);
+        if (scene == Scene::ObstaclePrompt) renderObstaclePrompt();
+        if (scene == Scene::GameOver) renderGameOver();
         SDL_RenderPresent(renderer);
 
-        SDL_Delay(100);
+        if (scene == Scene::Playing) SDL_Delay(config().tickMs);
     }
 
     cleanup();
@@ -135,30 +161,31 @@ int main(int argc, char* argv[]) {
 }
 
 void render(const vector<SnakeSegment>& snake, const SDL_Point& food, const SDL_Point& bonusFood) {
+    const int block = config().blockSize;
+
     // Render snake
     for (const auto& segment : snake) {
-        SDL_Rect rect = {segment.x * block_size, segment.y * block_size, block_size, block_size};
+        SDL_Rect rect = {segment.x * block, segment.y * block, block, block};
         SDL_SetRenderDrawColor(renderer, 0, 102, 204, 255);
         SDL_RenderFillRect(renderer, &rect);
     }
 
     // Render food
-    SDL_Rect foodRect = {food.x * block_size, food.y * block_size, block_size, block_size};
+    SDL_Rect foodRect = {food.x * block, food.y * block, block, block};
     SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
     SDL_RenderFillRect(renderer, &foodRect);
 
     // Render bonus food
     if (bonusFood.x != -1 && bonusFood.y != -1) {
-        SDL_Rect bonusFoodRect = {bonusFood.x * block_size, bonusFood.y * block_size, block_size, block_size};
+        SDL_Rect bonusFoodRect = {bonusFood.x * block, bonusFood.y * block, block, block};
         SDL_SetRenderDrawColor(renderer, 255, 255, 0, 255);
         SDL_RenderFillRect(renderer, &bonusFoodRect);
     }
 
     // Render obstacles
     SDL_SetRenderDrawColor(renderer, 0, 51, 0, 255);
-    SDL_RenderFillRect(renderer, &obstacle1);
-    SDL_RenderFillRect(renderer, &obstacle2);
-    SDL_RenderFillRect(renderer, &obstacle3);
+    const vector<SDL_Rect>& obstacles = config().obstacles;
+    SDL_RenderFillRects(renderer, obstacles.data(), (int)obstacles.size());
 }
 
 void update(vector<SnakeSegment>& snake, SDL_Point& food, SDL_Point& bonusFood, SDL_Keycode& direction, bool& bonusFoodActive) {
@@ -175,30 +202,25 @@ void update(vector<SnakeSegment>& snake, SDL_Point& food, SDL_Point& bonusFood,
     }
 
     // Wrap around the screen
-    if (headX < 0) headX = screen_width / block_size - 1;
-    if (headX >= screen_width / block_size) headX = 0;
-    if (headY < 0) headY = screen_height / block_size - 1;
-    if (headY >= screen_height / block_size) headY = 0;
+    if (headX < 0) headX = config().gridWidth - 1;
+    if (headX >= config().gridWidth) headX = 0;
+    if (headY < 0) headY = config().gridHeight - 1;
+    if (headY >= config().gridHeight) headY = 0;
 
     // Collision with the snake itself
     if (checkCollision(snake, headX, headY)) {
         Mix_PlayChannel(-1, gameOverSound, 0);
-        displayGameOver();
-        running = false;
+        scene = Scene::GameOver;
         return;
     }
 
-    // Define the snake's head rectangle for collision checks
-    SDL_Rect snakeHeadRect = {headX * block_size, headY * block_size, block_size, block_size};
-
-    // Check collision with obstacles
-    if (SDL_HasIntersection(&snakeHeadRect, &obstacle1) ||
-        SDL_HasIntersection(&snakeHeadRect, &obstacle2) ||
-        SDL_HasIntersection(&snakeHeadRect, &obstacle3)) {
-        if (!handleObstacleCollision()) { // Handle pause decision
-            running = false;
+    // Check collision with obstacles; once the player pays to continue, the move goes ahead
+    if (config().blocked(headX, headY)) {
+        if (!obstacleForgiven) {
+            scene = Scene::ObstaclePrompt;
             return;
         }
+        obstacleForgiven = false;
     }
 
     // Create a new head segment for the snake
@@ -208,8 +230,8 @@ void update(vector<SnakeSegment>& snake, SDL_Point& food, SDL_Point& bonusFood,
     if (headX == food.x && headY == food.y) {
         Mix_PlayChannel(-1, eatSound, 0);
         snake.insert(snake.begin(), newHead); // Grow the snake
-        food.x = rand() % (screen_width / block_size);
-        food.y = rand() % (screen_height / block_size);
+        food.x = rand() % (config().gridWidth);
+        food.y = rand() % (config().gridHeight);
         score++; // Increase the score
         updateScoreTexture();
 
@@ -233,43 +255,22 @@ void update(vector<SnakeSegment>& snake, SDL_Point& food, SDL_Point& bonusFood,
 
         
 
-bool handleObstacleCollision() {
-    bool resolved = false;
-    SDL_Event event;
-
+void renderObstaclePrompt() {
     // Render "Game Paused" message
     SDL_Color white = {255, 255, 255, 255};
     SDL_Surface* surface = TTF_RenderText_Solid(font, "Game Paused! Press Y to continue (-10 points), N to Quit", white);
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_Rect rect = {screen_width / 4, screen_height / 2, surface->w, surface->h};
+    SDL_Rect rect = {config().screenWidth / 4, config().screenHeight / 2, surface->w, surface->h};
     SDL_FreeSurface(surface);
     SDL_RenderCopy(renderer, texture, nullptr, &rect);
-    SDL_RenderPresent(renderer);
     SDL_DestroyTexture(texture);
-
-    while (!resolved) {
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                return false;
-            } else if (event.type == SDL_KEYDOWN) {
-                if (event.key.keysym.sym == SDLK_y) {
-                    score -= 10;
-                    updateScoreTexture();
-                    resolved = true;
-                } else if (event.key.keysym.sym == SDLK_n) {
-                    return false;
-                }
-            }
-        }
-    }
-    return true;
 }
 
 void spawnBonusFood(SDL_Point& bonusFood, const vector<SnakeSegment>& snake, const SDL_Point& food) {
     bool valid = false;
     while (!valid) {
-        bonusFood.x = rand() % (screen_width / block_size);
-        bonusFood.y = rand() % (screen_height / block_size);
+        bonusFood.x = rand() % (config().gridWidth);
+        bonusFood.y = rand() % (config().gridHeight);
         valid = !checkCollision(snake, bonusFood.x, bonusFood.y) && !(bonusFood.x == food.x && bonusFood.y == food.y);
     }
 }
@@ -295,24 +296,15 @@ bool checkCollision(const vector<SnakeSegment>& snake, int x, int y) {
     return false;
 }
 
-void displayGameOver() {
+void renderGameOver() {
     SDL_Color white = {255, 255, 255, 255};
     SDL_Surface* surface = TTF_RenderText_Solid(font, "Game Over! Press Any Key to Exit", white);
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_Rect rect = {screen_width / 4, screen_height / 2, surface->w, surface->h};
+    SDL_Rect rect = {config().screenWidth / 4, config().screenHeight / 2, surface->w, surface->h};
     SDL_FreeSurface(surface);
 
     SDL_RenderCopy(renderer, texture, nullptr, &rect);
-    SDL_RenderPresent(renderer);
     SDL_DestroyTexture(texture);
-
-    SDL_Event event;
-    while (true) {
-        SDL_WaitEvent(&event);
-        if (event.type == SDL_QUIT || event.type == SDL_KEYDOWN) {
-            break;
-        }
-    }
 }
 
 void cleanup() {
@@ -0,0 +1,54 @@
+#include "threadpool.h"
+using namespace std;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = 1;
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskReady.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ThreadPool::submit(function<void()> task) {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    taskReady.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<std::mutex> lock(mutex);
+    allDone.wait(lock, [this] { return tasks.empty() && busy == 0; });
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        function<void()> task;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+            ++busy;
+        }
+
+        task();
+
+        {
+            lock_guard<std::mutex> lock(mutex);
+            --busy;
+            if (tasks.empty() && busy == 0) allDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,213 @@
+#include "tournament.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "bot.h"
+#include "config.h"
+#include "game.h"
+#include "threadpool.h"
+using namespace std;
+
+namespace {
+
+const int bootstrap_samples = 200;
+const int fit_iterations = 200;
+const double rating_centre = 1500.0;
+
+struct Outcome {
+    int score = 0;
+    uint64_t ticks = 0;
+    bool won = false;
+    bool died = false;
+    double milliseconds = 0.0;
+};
+
+struct Standing {
+    Bot bot;
+    double rating = 0.0;
+    double low = 0.0;
+    double high = 0.0;
+    double meanScore = 0.0;
+    int wins = 0;
+    int deaths = 0;
+    double msPerGame = 0.0;
+};
+
+Outcome playGame(Autopilot& autopilot, uint64_t seed) {
+    const Uint64 start = SDL_GetPerformanceCounter();
+    GameState game;
+    resetGame(game, seed);
+    game.muted = true;
+    const uint64_t maxTicks = config().maxTicks;
+    autopilot.reset();
+    while (game.alive && game.ticks < maxTicks) {
+        turn(game, autopilot.move(game));
+        update(game);
+    }
+
+    Outcome outcome;
+    outcome.score = game.score;
+    outcome.ticks = game.ticks;
+    outcome.won = game.won;
+    outcome.died = !game.alive && !game.won;
+    outcome.milliseconds = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    return outcome;
+}
+
+// Bradley-Terry ratings for the bots from their scores on the given seeds (an index
+// may repeat), by the minorization-maximization iteration. scores is bots x games.
+vector<double> fitRatings(const vector<vector<int>>& scores, const vector<int>& seeds) {
+    const int bots = scores.size();
+    // points[i][j]: bot i's wins over j, draws counting half, starting from the one
+    // drawn match per pair
+    vector<vector<double>> points(bots, vector<double>(bots, 0.5));
+    for (int game : seeds) {
+        for (int i = 0; i < bots; ++i) {
+            for (int j = 0; j < bots; ++j) {
+                if (i == j) continue;
+                const int a = scores[i][game];
+                const int b = scores[j][game];
+                points[i][j] += a > b ? 1.0 : a == b ? 0.5 : 0.0;
+            }
+        }
+    }
+
+    const double matches = seeds.size() + 1.0; // Per pair, the drawn one included
+    vector<double> strength(bots, 1.0);
+    for (int iteration = 0; iteration < fit_iterations; ++iteration) {
+        vector<double> next(bots);
+        double logSum = 0.0;
+        for (int i = 0; i < bots; ++i) {
+            double won = 0.0;
+            double expected = 0.0;
+            for (int j = 0; j < bots; ++j) {
+                if (i == j) continue;
+                won += points[i][j];
+                expected += matches / (strength[i] + strength[j]);
+            }
+            next[i] = won / expected;
+            logSum += log(next[i]);
+        }
+        // Only ratios matter; keeping the geometric mean at 1 stops the scale drifting
+        const double scale = exp(logSum / bots);
+        for (int i = 0; i < bots; ++i) strength[i] = next[i] / scale;
+    }
+
+    vector<double> ratings(bots);
+    for (int i = 0; i < bots; ++i) ratings[i] = rating_centre + 400.0 * log10(strength[i]);
+    return ratings;
+}
+
+} // namespace
+
+int runTournament() {
+    const Config& settings = config();
+    const vector<Bot>& bots = settings.tournamentBots;
+    const int botCount = bots.size();
+    const int games = settings.games;
+    const uint64_t baseSeed = settings.seed ? settings.seed : SDL_GetPerformanceCounter();
+
+    vector<vector<Outcome>> outcomes(botCount, vector<Outcome>(games));
+    const unsigned threads = min<unsigned>(botCount * games, max(1u, thread::hardware_concurrency()));
+    cout << "Tournament: " << botCount << " bots on " << games << " seeds from " << baseSeed << ", " << threads
+         << (threads == 1 ? " thread" : " threads") << endl;
+
+    const Uint64 runStart = SDL_GetPerformanceCounter();
+    {
+        ThreadPool pool(threads);
+        // Each worker takes games seed by seed, so the slow bots' games are spread
+        // out, and keeps one autopilot per bot for all of them. The pool already has
+        // every core busy, so searches get one thread each.
+        const unsigned searchThreads = threads > 1 ? 1 : 0;
+        atomic<int> nextGame{0};
+        for (unsigned t = 0; t < threads; ++t) {
+            pool.submit([&outcomes, &bots, &nextGame, botCount, games, baseSeed, searchThreads] {
+                vector<unique_ptr<Autopilot>> autopilots(botCount);
+                for (int job; (job = nextGame.fetch_add(1)) < botCount * games;) {
+                    const int g = job / botCount;
+                    const int b = job % botCount;
+                    if (!autopilots[b]) autopilots[b].reset(new Autopilot(bots[b], searchThreads));
+                    outcomes[b][g] = playGame(*autopilots[b], baseSeed + g);
+                }
+            });
+        }
+        pool.wait();
+    }
+    const double runSeconds = (SDL_GetPerformanceCounter() - runStart) / (double)SDL_GetPerformanceFrequency();
+
+    vector<vector<int>> scores(botCount, vector<int>(games));
+    vector<Standing> standings(botCount);
+    uint64_t totalTicks = 0;
+    for (int b = 0; b < botCount; ++b) {
+        Standing& standing = standings[b];
+        standing.bot = bots[b];
+        double totalMs = 0.0;
+        long long totalScore = 0;
+        for (int g = 0; g < games; ++g) {
+            const Outcome& outcome = outcomes[b][g];
+            scores[b][g] = outcome.score;
+            totalScore += outcome.score;
+            standing.wins += outcome.won;
+            standing.deaths += outcome.died;
+            totalMs += outcome.milliseconds;
+            totalTicks += outcome.ticks;
+        }
+        standing.meanScore = double(totalScore) / games;
+        standing.msPerGame = totalMs / games;
+    }
+
+    vector<int> seeds(games);
+    for (int g = 0; g < games; ++g) seeds[g] = g;
+    const vector<double> ratings = fitRatings(scores, seeds);
+
+    // Resampling uses a generator of its own, so the intervals replay with the games
+    uint64_t state = baseSeed | 1;
+    vector<vector<double>> resampled(botCount);
+    for (int sample = 0; sample < bootstrap_samples; ++sample) {
+        for (int& seed : seeds) seed = (int)(xorshift32(state) % games);
+        const vector<double> sampleRatings = fitRatings(scores, seeds);
+        for (int b = 0; b < botCount; ++b) resampled[b].push_back(sampleRatings[b]);
+    }
+    for (int b = 0; b < botCount; ++b) {
+        sort(resampled[b].begin(), resampled[b].end());
+        standings[b].rating = ratings[b];
+        standings[b].low = resampled[b][(int)(bootstrap_samples * 0.025)];
+        standings[b].high = resampled[b][(int)(bootstrap_samples * 0.975) - 1];
+    }
+    stable_sort(standings.begin(), standings.end(), [](const Standing& a, const Standing& b) { return a.rating > b.rating; });
+
+    cout << fixed << setprecision(0);
+    cout << "  rank  bot          rating   95% interval  mean score   won  died   ms/game" << endl;
+    for (int r = 0; r < botCount; ++r) {
+        const Standing& s = standings[r];
+        cout << "  " << setw(4) << r + 1 << "  " << left << setw(11) << botName(s.bot) << right << setw(8) << s.rating << "  "
+             << setw(5) << s.low << " to " << setw(5) << s.high << setprecision(2) << setw(12) << s.meanScore << setw(6)
+             << s.wins << setw(6) << s.deaths << setw(10) << s.msPerGame << setprecision(0) << endl;
+    }
+    cout << "  " << botCount * games << " games, " << totalTicks << " ticks in " << setprecision(2) << runSeconds << " s ("
+         << setprecision(0) << botCount * games / max(runSeconds, 1e-6) << " games/s, " << totalTicks / max(runSeconds, 1e-6)
+         << " ticks/s)" << endl;
+
+    if (!settings.results.empty()) {
+        ofstream file(settings.results, ios::trunc);
+        file << "rank,bot,rating,low,high,mean_score,won,died,games,ms_per_game" << endl;
+        file << fixed;
+        for (int r = 0; r < botCount; ++r) {
+            const Standing& s = standings[r];
+            file << r + 1 << "," << botName(s.bot) << "," << setprecision(1) << s.rating << "," << s.low << "," << s.high << ","
+                 << setprecision(2) << s.meanScore << "," << s.wins << "," << s.deaths << "," << games << "," << s.msPerGame << endl;
+        }
+        if (!file) {
+            cerr << "Failed to write results to " << settings.results << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// --tournament: every bot in config().tournamentBots plays the same config().games
+// seeded games, all of them spread over a thread pool. Each worker keeps one autopilot
+// per bot from game to game, and search bots plan on a single thread when the pool has
+// more than one. On each seed every pair of bots is one match, won by the higher score
+// and drawn on a tie. Ratings are a Bradley-Terry fit of all the matches on the Elo
+// scale (400 points is 10 to 1 odds), centred on 1500, with one drawn match added
+// between every pair so a bot that never loses still gets a finite rating. The 95%
+// intervals come from refitting on the seed set resampled with replacement.
+//
+// Prints a table of ratings, scores and time per game, sorted best first, and writes
+// it as CSV to config().results when that's set. Search bots think for a fixed time
+// per move, so their results depend on the machine and its load; the rest replay
+// exactly from config().seed. Returns the exit code.
+int runTournament();
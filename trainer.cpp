@@ -0,0 +1,215 @@
+#include "trainer.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SDL2/SDL.h>
+#include "config.h"
+#include "game.h"
+#include "metrics.h"
+#include "network.h"
+#include "policy.h"
+#include "threadpool.h"
+using namespace std;
+
+namespace {
+
+const int mutation_rate = 32;    // One weight in this many changes per child
+const int mutation_step = 24;    // Largest change to a weight
+const int bias_step = 1 << 12;   // Largest change to a bias
+
+struct Generator {
+    uint64_t state;
+
+    uint32_t next() { return xorshift32(state); }
+
+    // Roughly normal, from -limit to limit
+    int spread(int limit) {
+        return (int)(next() % (limit + 1)) - (int)(next() % (limit + 1));
+    }
+};
+
+struct Member {
+    Network network;
+    double fitness = 0.0;
+};
+
+double secondsSince(Uint64 start) {
+    return (SDL_GetPerformanceCounter() - start) / (double)SDL_GetPerformanceFrequency();
+}
+
+// How far the head is from the food, or 0 when there's none left to eat
+int foodDistance(const GameState& game) {
+    return game.food.x >= 0 ? wrappedDistance(game.snake.front(), game.food) : 0;
+}
+
+// Plays the games side by side with the network and returns their mean fitness: the
+// score, plus the share of the distance to the next food the snake had closed when
+// the game ended. That's worth less than a meal, but it tells apart policies that
+// haven't learnt to eat yet, which is all of them early on.
+double evaluate(const Network& network, uint64_t firstSeed, int count) {
+    const Config& settings = config();
+    const uint64_t hunger = settings.gridWidth * settings.gridHeight;
+    vector<GameState> games(count);
+    vector<uint64_t> lastMeal(count, 0);
+    vector<int> startDistance(count);   // From the head to the food at the last meal
+    vector<int> closestDistance(count); // Nearest the head has been to it since
+    for (int i = 0; i < count; ++i) {
+        resetGame(games[i], firstSeed + i);
+        games[i].muted = true;
+        startDistance[i] = closestDistance[i] = foodDistance(games[i]);
+    }
+
+    NeuralPolicy policy(&network);
+    vector<const GameState*> playing(count);
+    vector<int> index(count);
+    vector<SDL_Keycode> directions(count);
+    while (true) {
+        int active = 0;
+        for (int i = 0; i < count; ++i) {
+            const GameState& game = games[i];
+            if (!game.alive || game.ticks >= (uint64_t)settings.maxTicks || game.ticks - lastMeal[i] > hunger) continue;
+            playing[active] = &game;
+            index[active++] = i;
+        }
+        if (active == 0) break;
+        policy.moves(playing.data(), active, directions.data());
+        for (int a = 0; a < active; ++a) {
+            GameState& game = games[index[a]];
+            const int i = index[a];
+            const int score = game.score;
+            turn(game, directions[a]);
+            update(game);
+            if (game.score != score) {
+                lastMeal[i] = game.ticks;
+                startDistance[i] = closestDistance[i] = foodDistance(game);
+            } else if (game.alive) {
+                closestDistance[i] = min(closestDistance[i], foodDistance(game));
+            }
+        }
+    }
+
+    double total = 0.0;
+    for (int i = 0; i < count; ++i) {
+        total += games[i].score;
+        if (startDistance[i] > 0) total += 1.0 - (double)closestDistance[i] / startDistance[i];
+    }
+    return total / count;
+}
+
+void mutate(Network& network, Generator& random) {
+    for (NetworkLayer& layer : network.layers) {
+        for (int r = 0; r < layer.outputs; ++r) {
+            int8_t* row = &layer.weights[(size_t)r * layer.stride];
+            for (int k = 0; k < layer.inputs; ++k) {
+                if (random.next() % mutation_rate) continue;
+                row[k] = (int8_t)max(-127, min(127, row[k] + random.spread(mutation_step)));
+            }
+            if (random.next() % mutation_rate == 0) layer.bias[r] += random.spread(bias_step);
+        }
+    }
+}
+
+// policy.snn and 12 make policy-gen0012.snn
+string checkpointPath(const string& policy, int generation) {
+    ostringstream number;
+    number << "-gen" << setw(4) << setfill('0') << generation;
+    const size_t dot = policy.rfind('.');
+    const size_t slash = policy.find_last_of("/\\");
+    if (dot == string::npos || (slash != string::npos && dot < slash)) return policy + number.str();
+    return policy.substr(0, dot) + number.str() + policy.substr(dot);
+}
+
+} // namespace
+
+int runTrainer() {
+    const Config& settings = config();
+    const uint64_t baseSeed = settings.seed ? settings.seed : SDL_GetPerformanceCounter();
+    Generator random = {baseSeed * 0x9E3779B97F4A7C15ull | 1};
+
+    Network start;
+    bool resumed = false;
+    if (ifstream(settings.policy)) {
+        resumed = start.load(settings.policy) && start.inputs() == observation_size && start.outputs() == policy_actions;
+        if (!resumed) cerr << settings.policy << " doesn't fit the policy; starting from random weights" << endl;
+    }
+    vector<Member> population(settings.population);
+    for (int m = 0; m < settings.population; ++m) {
+        Network& network = population[m].network;
+        if (resumed) {
+            network = start;
+            if (m > 0) mutate(network, random);
+        } else {
+            network.initialize({observation_size, settings.trainHidden, policy_actions}, random.next() | (uint64_t)random.next() << 32);
+        }
+    }
+
+    const unsigned threads = min<unsigned>(settings.population, max(1u, thread::hardware_concurrency()));
+    const int elite = max(1, settings.population / 8);
+    const int parents = max(elite, settings.population / 4);
+    cout << "Training " << settings.population << " policies (" << observation_size << "-" << settings.trainHidden << "-"
+         << policy_actions << ") on " << settings.trainGames << " games each, " << threads << (threads == 1 ? " thread, " : " threads, ")
+         << (resumed ? "from " + settings.policy : string("from random weights")) << endl;
+
+    ThreadPool pool(threads);
+    vector<Member> next(settings.population);
+    // The network in the policy file. Fitness is only comparable on the same games, so
+    // it plays each generation's games too and is replaced only by a member that beats
+    // it on them.
+    Member champion;
+    bool haveChampion = resumed;
+    if (resumed) champion.network = start;
+    uint64_t totalGames = 0;
+    const Uint64 runStart = SDL_GetPerformanceCounter();
+    for (int generation = 1; generation <= settings.generations; ++generation) {
+        // Every member plays the same games, new ones each generation
+        const uint64_t firstSeed = baseSeed + (uint64_t)(generation - 1) * settings.trainGames;
+        const Uint64 start = SDL_GetPerformanceCounter();
+        for (Member& member : population) {
+            pool.submit([&member, firstSeed, &settings] { member.fitness = evaluate(member.network, firstSeed, settings.trainGames); });
+        }
+        if (haveChampion) {
+            pool.submit([&champion, firstSeed, &settings] { champion.fitness = evaluate(champion.network, firstSeed, settings.trainGames); });
+        }
+        pool.wait();
+        const double seconds = secondsSince(start);
+        const int games = (settings.population + haveChampion) * settings.trainGames;
+        totalGames += games;
+
+        stable_sort(population.begin(), population.end(), [](const Member& a, const Member& b) { return a.fitness > b.fitness; });
+        double mean = 0.0;
+        for (const Member& member : population) mean += member.fitness;
+        mean /= settings.population;
+        const bool replaced = !haveChampion || population[0].fitness > champion.fitness;
+        cout << fixed << setprecision(2) << "generation " << generation << ": best " << population[0].fitness << ", mean " << mean;
+        if (haveChampion) cout << ", saved policy " << champion.fitness << (replaced ? " (replaced)" : "");
+        cout << ", " << games << " games in " << seconds << " s (" << setprecision(0) << games / max(seconds, 1e-6) << " games/s)"
+             << endl;
+
+        if (replaced) {
+            champion = population[0];
+            haveChampion = true;
+            if (!champion.network.save(settings.policy)) return 1;
+        }
+        if (generation % settings.checkpointEvery == 0 && !champion.network.save(checkpointPath(settings.policy, generation))) {
+            return 1;
+        }
+
+        for (int m = 0; m < settings.population; ++m) {
+            next[m].network = population[m < elite ? m : random.next() % parents].network;
+            if (m >= elite) mutate(next[m].network, random);
+        }
+        swap(population, next);
+    }
+
+    const double seconds = secondsSince(runStart);
+    cout << fixed << setprecision(0) << "Trained " << settings.generations << " generations: " << totalGames << " games in "
+         << setprecision(2) << seconds << " s (" << setprecision(0) << totalGames / max(seconds, 1e-6) << " games/s, "
+         << metrics.inferences.load() / max(seconds, 1e-6) << " inferences/s), fitness " << setprecision(2) << champion.fitness
+         << " saved to " << settings.policy << endl;
+    return 0;
+}
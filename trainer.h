@@ -0,0 +1,18 @@
+#pragma once
+
+// --train: evolves policy networks for the neural bot. Each generation every member
+// of a config().population strong population plays the same config().trainGames
+// seeded games, one thread per member and all of a member's games in one batch. The
+// best eighth carry over unchanged and the rest are mutated copies of members picked
+// from the top quarter. Fitness is the mean score plus how close the snake got to its
+// next food, worth less than a meal; a game also ends when the snake goes a board's
+// worth of ticks without eating, so circling doesn't stall a generation.
+//
+// Starts from config().policy when it holds a network of the right shape, otherwise
+// from random weights. The network in config().policy plays every generation's games
+// alongside the population and is overwritten only by a member that beats it on them,
+// so one lucky set of seeds can't replace it. It's also kept as a numbered checkpoint
+// (policy-gen0010.snn) every config().checkpointEvery generations. Seeds come from
+// config().seed, so a run replays exactly on any number of threads. Prints each
+// generation's scores and games per second; returns the exit code.
+int runTrainer();
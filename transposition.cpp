@@ -0,0 +1,63 @@
+#include "transposition.h"
+using namespace std;
+
+namespace {
+
+uint64_t pack(const TableEntry& entry, uint32_t generation) {
+    return entry.visits | (uint64_t)entry.value << 32 | (uint64_t)generation << 48;
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    // Largest power of two number of buckets that fits, so a key maps with a mask
+    size_t count = 1;
+    while (count * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024) count *= 2;
+    buckets.reset(new Bucket[count]);
+    mask = count - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t b = 0; b <= mask; ++b) {
+        for (int s = 0; s < slots; ++s) {
+            buckets[b].check[s].store(0, memory_order_relaxed);
+            buckets[b].data[s].store(0, memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, TableEntry& entry) const {
+    const Bucket& bucket = buckets[key & mask];
+    for (int s = 0; s < slots; ++s) {
+        const uint64_t data = bucket.data[s].load(memory_order_relaxed);
+        if ((bucket.check[s].load(memory_order_relaxed) ^ data) != key || data == 0) continue;
+        entry.visits = (uint32_t)data;
+        entry.value = (uint16_t)(data >> 32);
+        return true;
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, const TableEntry& entry) {
+    Bucket& bucket = buckets[key & mask];
+    int victim = 0;
+    uint64_t victimRank = ~0ull;
+    for (int s = 0; s < slots; ++s) {
+        const uint64_t data = bucket.data[s].load(memory_order_relaxed);
+        if ((bucket.check[s].load(memory_order_relaxed) ^ data) == key) {
+            victim = s;
+            break;
+        }
+        // Older generations go first, then fewer visits
+        const uint64_t rank = (uint64_t)(((data >> 48) & 0xFF) == generation) << 32 | (uint32_t)data;
+        if (rank < victimRank) {
+            victim = s;
+            victimRank = rank;
+        }
+    }
+    const uint64_t data = pack(entry, generation);
+    bucket.data[victim].store(data, memory_order_relaxed);
+    bucket.check[victim].store(key ^ data, memory_order_relaxed);
+}
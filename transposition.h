@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// What search has learnt about a position: how many playouts have scored it, and
+// their mean reward scaled to 0..65535
+struct TableEntry {
+    uint32_t visits = 0;
+    uint16_t value = 0;
+};
+
+// Lock-free transposition table from GameState::hash to TableEntry, shared by every
+// thread of a search and kept from one move to the next. Each slot holds the entry's
+// bits and the key XORed with them, as two relaxed atomics; a slot torn by a write on
+// another thread fails the key check and reads as a miss rather than as some other
+// position. Four slots make a bucket of one 64-byte cache line, so a probe touches one
+// line. A store overwrites the key's own slot if it has one, else the slot with the
+// fewest visits, preferring slots left over from an earlier move. Concurrent updates
+// of one entry can lose each other's samples; the table is a hint, not a record.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t megabytes);
+
+    bool probe(uint64_t key, TableEntry& entry) const;
+    void store(uint64_t key, const TableEntry& entry);
+
+    // Forgets every entry, for a fresh game
+    void clear();
+
+    // Marks what is in the table as old, to be replaced first; call once per move
+    void age() { generation = (generation + 1) & 0xFF; }
+
+private:
+    static const int slots = 4;
+    struct alignas(64) Bucket {
+        std::atomic<uint64_t> check[slots]; // key ^ data
+        std::atomic<uint64_t> data[slots];  // visits | value << 32 | generation << 48
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t mask = 0;
+    uint32_t generation = 0;
+};
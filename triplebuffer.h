@@ -0,0 +1,36 @@
+#pragma once
+#include <atomic>
+
+// Lock-free triple buffer handing the latest value from one writer thread to one reader
+// thread. The writer fills back() and publishes it; read() returns the most recently
+// published value. Neither side ever waits on the other: the writer always has a slot
+// of its own, and a reader that falls behind just skips the values it missed.
+template <typename T>
+class TripleBuffer {
+public:
+    // Writer side
+    T& back() { return slots[backIndex]; }
+
+    void publish() {
+        unsigned previous = middle.exchange(backIndex | fresh_bit, std::memory_order_acq_rel);
+        backIndex = previous & index_mask;
+    }
+
+    // Reader side. The reference stays valid until the next call.
+    const T& read() {
+        if (middle.load(std::memory_order_relaxed) & fresh_bit) {
+            unsigned previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+            frontIndex = previous & index_mask;
+        }
+        return slots[frontIndex];
+    }
+
+private:
+    static const unsigned index_mask = 3;
+    static const unsigned fresh_bit = 4;
+
+    T slots[3];
+    alignas(64) std::atomic<unsigned> middle{1};
+    alignas(64) unsigned backIndex = 0;
+    alignas(64) unsigned frontIndex = 2;
+};